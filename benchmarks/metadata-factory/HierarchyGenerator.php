@@ -0,0 +1,131 @@
+<?php
+
+namespace Doctrine\Benchmarks\MetadataFactory;
+
+/**
+ * Generates and loads synthetic document hierarchies.
+ *
+ * Every root is a single collection inheritance tree: each class has
+ * `width` subclasses down to `depth` levels below the root, and declares
+ * `fields` string fields of its own.
+ */
+class HierarchyGenerator
+{
+    const NAMESPACE_NAME = 'Doctrine\Benchmarks\MetadataFactory\Generated';
+
+    private $roots;
+    private $depth;
+    private $width;
+    private $fields;
+
+    /** @var array Class name => parent class name or null */
+    private $parents = array();
+
+    /** @var array Class name => declared field names */
+    private $declaredFields = array();
+
+    /** @var array Root class name => class names of the tree, root first */
+    private $trees = array();
+
+    public function __construct($roots, $depth, $width, $fields)
+    {
+        $this->roots = (int) $roots;
+        $this->depth = (int) $depth;
+        $this->width = (int) $width;
+        $this->fields = (int) $fields;
+    }
+
+    /**
+     * Writes the classes to a file in $dir and includes it. The file name
+     * depends on the shape, so several runs in one process do not clash.
+     *
+     * @return array All generated class names
+     */
+    public function load($dir)
+    {
+        $code = "<?php\n\nnamespace " . self::NAMESPACE_NAME . ";\n\n";
+
+        for ($r = 0; $r < $this->roots; $r++) {
+            $root = 'Root' . $r;
+            $this->trees[$this->fqcn($root)] = array();
+            $code .= $this->generate($root, null, 0, $this->fqcn($root));
+        }
+
+        $file = sprintf('%s/doctrine-bench-%d-%d-%d-%d.php', $dir, $this->roots, $this->depth, $this->width, $this->fields);
+        file_put_contents($file, $code);
+        require_once $file;
+
+        return array_keys($this->parents);
+    }
+
+    public function getParent($className)
+    {
+        return $this->parents[$className];
+    }
+
+    public function getDeclaredFields($className)
+    {
+        return $this->declaredFields[$className];
+    }
+
+    public function getTree($rootClassName)
+    {
+        return $this->trees[$rootClassName];
+    }
+
+    public function getRoot($className)
+    {
+        while ($this->parents[$className] !== null) {
+            $className = $this->parents[$className];
+        }
+
+        return $className;
+    }
+
+    /**
+     * @return array The deepest classes, the ones requests usually ask for
+     */
+    public function getLeaves()
+    {
+        $leaves = array();
+        foreach ($this->parents as $className => $parent) {
+            if ( ! in_array($className, $this->parents, true)) {
+                $leaves[] = $className;
+            }
+        }
+
+        return $leaves;
+    }
+
+    private function generate($shortName, $parentShortName, $level, $rootClassName)
+    {
+        $className = $this->fqcn($shortName);
+        $this->parents[$className] = $parentShortName === null ? null : $this->fqcn($parentShortName);
+        $this->trees[$rootClassName][] = $className;
+
+        $fields = array();
+        $code = 'class ' . $shortName . ($parentShortName === null ? '' : ' extends ' . $parentShortName) . "\n{\n";
+        if ($parentShortName === null) {
+            $code .= "    protected \$id;\n";
+        }
+        for ($f = 0; $f < $this->fields; $f++) {
+            $fields[] = $name = lcfirst($shortName) . 'Field' . $f;
+            $code .= '    protected $' . $name . ";\n";
+        }
+        $code .= "}\n\n";
+        $this->declaredFields[$className] = $fields;
+
+        if ($level < $this->depth) {
+            for ($w = 0; $w < $this->width; $w++) {
+                $code .= $this->generate($shortName . '_' . $w, $shortName, $level + 1, $rootClassName);
+            }
+        }
+
+        return $code;
+    }
+
+    private function fqcn($shortName)
+    {
+        return self::NAMESPACE_NAME . '\\' . $shortName;
+    }
+}
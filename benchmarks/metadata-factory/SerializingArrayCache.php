@@ -0,0 +1,50 @@
+<?php
+
+namespace Doctrine\Benchmarks\MetadataFactory;
+
+use Doctrine\Common\Cache\CacheProvider;
+
+/**
+ * In-memory cache driver that serializes like a real backend does, so cached
+ * lookups pay for unserialize() and wakeup as they would in production.
+ */
+class SerializingArrayCache extends CacheProvider
+{
+    private $data = array();
+
+    protected function doFetch($id)
+    {
+        return isset($this->data[$id]) ? unserialize($this->data[$id]) : false;
+    }
+
+    protected function doContains($id)
+    {
+        return isset($this->data[$id]);
+    }
+
+    protected function doSave($id, $data, $lifeTime = 0)
+    {
+        $this->data[$id] = serialize($data);
+
+        return true;
+    }
+
+    protected function doDelete($id)
+    {
+        unset($this->data[$id]);
+
+        return true;
+    }
+
+    protected function doFlush()
+    {
+        $this->data = array();
+
+        return true;
+    }
+
+    protected function doGetStats()
+    {
+        return null;
+    }
+}
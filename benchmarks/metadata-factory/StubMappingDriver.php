@@ -0,0 +1,55 @@
+<?php
+
+namespace Doctrine\Benchmarks\MetadataFactory;
+
+use Doctrine\Common\Persistence\Mapping\ClassMetadata;
+use Doctrine\Common\Persistence\Mapping\Driver\MappingDriver;
+
+/**
+ * Maps the generated hierarchies without reading annotations or files, so
+ * the benchmark measures the factory and not the driver.
+ */
+class StubMappingDriver implements MappingDriver
+{
+    private $generator;
+    private $classNames;
+    private $mapped;
+
+    public function __construct(HierarchyGenerator $generator, array $classNames)
+    {
+        $this->generator = $generator;
+        $this->classNames = $classNames;
+        $this->mapped = array_flip($classNames);
+    }
+
+    public function loadMetadataForClass($className, ClassMetadata $metadata)
+    {
+        if ($this->generator->getParent($className) === null) {
+            $discriminatorMap = array();
+            foreach ($this->generator->getTree($className) as $i => $treeClassName) {
+                $discriminatorMap['t' . $i] = $treeClassName;
+            }
+
+            $metadata->setInheritanceType(2); // ClassMetadata::INHERITANCE_TYPE_SINGLE_COLLECTION
+            $metadata->setDiscriminatorField('type');
+            $metadata->setDiscriminatorMap($discriminatorMap);
+            $metadata->setCollection(substr($className, strrpos($className, '\\') + 1));
+            $metadata->mapField(array('fieldName' => 'id', 'id' => true));
+            $metadata->addIndex(array('type' => 1), array());
+        }
+
+        foreach ($this->generator->getDeclaredFields($className) as $fieldName) {
+            $metadata->mapField(array('fieldName' => $fieldName, 'type' => 'string'));
+        }
+    }
+
+    public function getAllClassNames()
+    {
+        return $this->classNames;
+    }
+
+    public function isTransient($className)
+    {
+        return ! isset($this->mapped[$className]);
+    }
+}
@@ -0,0 +1,205 @@
+<?php
+
+/*
+ * Benchmark of the ODM ClassMetadataFactory on synthetic hierarchies.
+ *
+ * Usage:
+ *   php -d extension=doctrine.so bench.php --autoload=/path/to/vendor/autoload.php \
+ *       [--roots=10] [--depth=3] [--width=3] [--fields=20] [--iterations=5] [--output=results.json]
+ *
+ * The autoloader must provide doctrine/mongodb-odm and its dependencies.
+ * Results are printed as JSON (or written to --output): per phase the
+ * median over the iterations, in microseconds per class, plus throughput
+ * and memory figures.
+ *
+ * Run it again with -d doctrine.real_class_cache=0 to see what the real
+ * class name memo saves in real_class_ns.
+ */
+
+use Doctrine\Benchmarks\MetadataFactory\HierarchyGenerator;
+use Doctrine\Benchmarks\MetadataFactory\SerializingArrayCache;
+use Doctrine\Benchmarks\MetadataFactory\StubMappingDriver;
+use Doctrine\Common\EventManager;
+use Doctrine\Common\Util\ClassUtils;
+use Doctrine\MongoDB\Connection;
+use Doctrine\ODM\MongoDB\Configuration;
+use Doctrine\ODM\MongoDB\DocumentManager;
+use Doctrine\ODM\MongoDB\Mapping\ClassMetadataFactory;
+
+$options = getopt('', array('autoload:', 'roots::', 'depth::', 'width::', 'fields::', 'iterations::', 'output::'));
+if (empty($options['autoload'])) {
+    fwrite(STDERR, "Usage: php bench.php --autoload=vendor/autoload.php [--roots=10] [--depth=3] [--width=3] [--fields=20] [--iterations=5] [--output=file]\n");
+    exit(2);
+}
+
+$options += array('roots' => 10, 'depth' => 3, 'width' => 3, 'fields' => 20, 'iterations' => 5, 'output' => null);
+$iterations = max(1, (int) $options['iterations']);
+
+require $options['autoload'];
+require __DIR__ . '/HierarchyGenerator.php';
+require __DIR__ . '/StubMappingDriver.php';
+require __DIR__ . '/SerializingArrayCache.php';
+
+$generator = new HierarchyGenerator($options['roots'], $options['depth'], $options['width'], $options['fields']);
+$classNames = $generator->load(sys_get_temp_dir());
+$leaves = $generator->getLeaves();
+
+$config = new Configuration();
+$config->setMetadataDriverImpl(new StubMappingDriver($generator, $classNames));
+$config->setProxyDir(sys_get_temp_dir());
+$config->setProxyNamespace('Proxies');
+$config->setHydratorDir(sys_get_temp_dir());
+$config->setHydratorNamespace('Hydrators');
+$config->setDefaultDB('doctrine_bench');
+
+$dm = DocumentManager::create(new Connection(), $config, new EventManager());
+
+function createFactory(DocumentManager $dm, Configuration $config, $cache = null)
+{
+    $factory = new ClassMetadataFactory();
+    $factory->setDocumentManager($dm);
+    $factory->setConfiguration($config);
+    if ($cache !== null) {
+        $factory->setCacheDriver($cache);
+    }
+
+    return $factory;
+}
+
+/**
+ * Calls getMetadataFor() for every class and returns microseconds per call
+ */
+function timeLookups(ClassMetadataFactory $factory, array $classNames)
+{
+    $start = microtime(true);
+    foreach ($classNames as $className) {
+        $factory->getMetadataFor($className);
+    }
+
+    return (microtime(true) - $start) * 1e6 / count($classNames);
+}
+
+function median(array $values)
+{
+    sort($values);
+    $count = count($values);
+
+    return $count % 2 ? $values[$count >> 1] : ($values[($count >> 1) - 1] + $values[$count >> 1]) / 2;
+}
+
+/**
+ * Calls ClassUtils::getRealClass() for every name and returns nanoseconds per call
+ */
+function timeRealClass(array $names, $rounds)
+{
+    $start = microtime(true);
+    for ($i = 0; $i < $rounds; $i++) {
+        foreach ($names as $name) {
+            ClassUtils::getRealClass($name);
+        }
+    }
+
+    return (microtime(true) - $start) * 1e9 / ($rounds * count($names));
+}
+
+$cold = $warm = $cached = $snapshot = $allCold = $allCached = $realPlain = $realProxy = array();
+
+// Cold: fresh factory, no cache, every class goes through the driver
+for ($i = 0; $i < $iterations; $i++) {
+    $factory = createFactory($dm, $config);
+    $cold[] = timeLookups($factory, $leaves);
+    $warm[] = timeLookups($factory, $leaves);
+}
+
+// Cached: fresh factory over a filled cache driver
+$cache = new SerializingArrayCache();
+createFactory($dm, $config, $cache)->getAllMetadata();
+for ($i = 0; $i < $iterations; $i++) {
+    $cached[] = timeLookups(createFactory($dm, $config, $cache), $leaves);
+}
+
+// Snapshot: fresh factory over a snapshot image, entries are still unserialized
+$snapshotPath = tempnam(sys_get_temp_dir(), 'doctrine-bench-snapshot');
+createFactory($dm, $config)->dumpMetadataSnapshot($snapshotPath, 'bench');
+for ($i = 0; $i < $iterations; $i++) {
+    $factory = createFactory($dm, $config);
+    $factory->setMetadataSnapshot($snapshotPath, 'bench');
+    $snapshot[] = timeLookups($factory, $leaves);
+}
+unlink($snapshotPath);
+
+// getAllMetadata() throughput, without and with the cache driver
+for ($i = 0; $i < $iterations; $i++) {
+    $start = microtime(true);
+    createFactory($dm, $config)->getAllMetadata();
+    $allCold[] = count($classNames) / (microtime(true) - $start);
+
+    $start = microtime(true);
+    createFactory($dm, $config, $cache)->getAllMetadata();
+    $allCached[] = count($classNames) / (microtime(true) - $start);
+}
+
+// Real class names of documents and of their proxies, as during a flush
+$proxyNames = array();
+foreach ($leaves as $className) {
+    $proxyNames[] = 'Proxies\\__CG__\\' . $className;
+}
+for ($i = 0; $i < $iterations; $i++) {
+    $realPlain[] = timeRealClass($leaves, 1000);
+    $realProxy[] = timeRealClass($proxyNames, 1000);
+}
+
+// Memory held by the metadata of every class
+gc_collect_cycles();
+$before = memory_get_usage();
+$factory = createFactory($dm, $config);
+$factory->getAllMetadata();
+$retained = memory_get_usage() - $before;
+
+$results = array(
+    'php' => PHP_VERSION,
+    'extension' => phpversion('doctrine'),
+    'metadata_store_size' => (int) ini_get('doctrine.metadata_store_size'),
+    'shape' => array(
+        'roots' => (int) $options['roots'],
+        'depth' => (int) $options['depth'],
+        'width' => (int) $options['width'],
+        'fields' => (int) $options['fields'],
+        'classes' => count($classNames),
+        'leaves' => count($leaves),
+    ),
+    'iterations' => $iterations,
+    'get_metadata_for_us' => array(
+        'cold' => median($cold),
+        'warm' => median($warm),
+        'cached' => median($cached),
+        'snapshot' => median($snapshot),
+    ),
+    'get_all_metadata_classes_per_s' => array(
+        'cold' => median($allCold),
+        'cached' => median($allCached),
+    ),
+    'real_class_ns' => array(
+        'plain' => median($realPlain),
+        'proxy' => median($realProxy),
+    ),
+    'memory' => array(
+        'retained_bytes' => $retained,
+        'retained_bytes_per_class' => (int) ($retained / count($classNames)),
+        'peak_bytes' => memory_get_peak_usage(),
+    ),
+);
+
+if (function_exists('doctrine_metadata_stats') && ($stats = doctrine_metadata_stats()) !== false) {
+    $results['factory_stats'] = $stats;
+}
+if (function_exists('doctrine_real_class_cache_info')) {
+    $results['real_class_cache'] = doctrine_real_class_cache_info();
+}
+
+$json = json_encode($results, defined('JSON_PRETTY_PRINT') ? JSON_PRETTY_PRINT : 0) . "\n";
+if ($options['output']) {
+    file_put_contents($options['output'], $json);
+} else {
+    echo $json;
+}
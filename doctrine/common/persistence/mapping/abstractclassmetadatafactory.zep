@@ -19,6 +19,8 @@
 namespace Doctrine\Common\Persistence\Mapping;
 
 use Doctrine\Common\Cache\Cache;
+use Doctrine\Common\Cache\MultiGetCache;
+use Doctrine\Common\Cache\MultiPutCache;
 use Doctrine\Common\Util\ClassUtils;
 
 /**
@@ -36,6 +38,21 @@ use Doctrine\Common\Util\ClassUtils;
  */
 abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 {
+	/**
+	 * Counters of doctrine_metadata_stats(), in the order of the extension.
+	 * The last four are timed phases.
+	 */
+	const STAT_LOADED_HITS = 0;
+	const STAT_LOCAL_CACHE_HITS = 1;
+	const STAT_CACHE_HITS = 2;
+	const STAT_CACHE_MISSES = 3;
+	const STAT_ALIAS_RESOLUTIONS = 4;
+	const STAT_CLAIM_WAITS = 5;
+	const STAT_GET_METADATA_FOR = 6;
+	const STAT_LOAD_METADATA = 7;
+	const STAT_DO_LOAD_METADATA = 8;
+	const STAT_CACHE_FETCH = 9;
+
 	/**
 	 * Salt used by specific Object Manager implementation.
 	 *
@@ -63,6 +80,65 @@ abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 	 */
 	protected reflectionService = null;
 
+	/**
+	 * Handle of the mapped metadata snapshot, if any.
+	 *
+	 * @var int|null
+	 */
+	protected snapshot = null;
+
+	/**
+	 * Resolved class names indexed by their "Alias:ClassName" notation.
+	 *
+	 * @var array
+	 */
+	protected aliasMap = [];
+
+	/**
+	 * Non-transient parent classes, topmost first, indexed by class name.
+	 *
+	 * @var array
+	 */
+	protected parentClassesCache = [];
+
+	/**
+	 * Whether loads are reported to doctrine_metadata_stats(), null until
+	 * the first load checks whether the counters are compiled in. Each
+	 * report is a PHP function call into the extension, a few hundred
+	 * nanoseconds, which is why builds without the counters never make it.
+	 *
+	 * @var bool|null
+	 */
+	protected collectStats = null;
+
+	/**
+	 * Whether cached entries are checked against their files before use.
+	 *
+	 * @var bool
+	 */
+	protected revalidateCache = false;
+
+	/**
+	 * Modification time and inode of the files stat'ed by this factory.
+	 *
+	 * @var array
+	 */
+	protected fileStats = [];
+
+	/**
+	 * In-process cache in front of the cache driver, if any.
+	 *
+	 * @var LocalMetadataCache|null
+	 */
+	protected localCache = null;
+
+	/**
+	 * Lifetime in seconds of negative entries in the local cache.
+	 *
+	 * @var int
+	 */
+	protected negativeCacheTtl = 60;
+
 	/**
 	 * Sets the cache driver used by the factory to cache ClassMetadata instances.
 	 *
@@ -85,6 +161,94 @@ abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 		return this->cacheDriver;
 	}
 
+	/**
+	 * Uses a metadata snapshot written by dumpMetadataSnapshot() to answer
+	 * getMetadataFor() without going through the mapping driver or the cache.
+	 * Entries are unserialized when they are fetched, like cached ones.
+	 *
+	 * A snapshot written for another version, or that fails its checksum, is
+	 * refused and the factory keeps loading metadata the usual way.
+	 *
+	 * @param string path
+	 * @param string version
+	 *
+	 * @return boolean TRUE if the snapshot is in use, FALSE otherwise.
+	 */
+	public function setMetadataSnapshot(string path, string version)
+	{
+		var snapshot;
+
+		let snapshot = doctrine_metadata_snapshot_open(path, version);
+		if snapshot === false {
+			let this->snapshot = null;
+			return false;
+		}
+
+		let this->snapshot = snapshot;
+		return true;
+	}
+
+	/**
+	 * Loads the metadata of every mapped class and writes it to a snapshot
+	 * image, meant to be run once per deploy.
+	 *
+	 * @param string path
+	 * @param string version
+	 *
+	 * @return boolean
+	 */
+	public function dumpMetadataSnapshot(string path, string version)
+	{
+		return this->writeMetadataSnapshot(path, version, this->getAllMetadata());
+	}
+
+	/**
+	 * Writes the given ClassMetadata instances to a snapshot image.
+	 *
+	 * @param string path
+	 * @param string version
+	 * @param array  metadata
+	 *
+	 * @return boolean
+	 */
+	public function writeMetadataSnapshot(string path, string version, array metadata)
+	{
+		var entries, class1;
+
+		let entries = [];
+		for class1 in metadata {
+			let entries[class1->getName() . this->cacheSalt] = class1;
+		}
+
+		return doctrine_metadata_snapshot_write(path, entries, version);
+	}
+
+	/**
+	 * Saves the given ClassMetadata instances to the cache driver, as
+	 * loading them would have.
+	 *
+	 * @param array metadata
+	 *
+	 * @return void
+	 */
+	public function saveMetadata(array metadata)
+	{
+		var entries, class1;
+
+		if !this->cacheDriver {
+			return;
+		}
+
+		let entries = [];
+		for class1 in metadata {
+			let entries[class1->getName() . this->cacheSalt] = class1;
+		}
+
+		if count(entries) {
+			this->saveCachedMetadata(entries);
+		}
+	}
+
 	/**
 	 * Returns an array of all the loaded metadata currently in memory.
 	 *
@@ -103,21 +267,190 @@ abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 	 */
 	public function getAllMetadata()
 	{
-		var driver, metadata, className;
+		return this->getMetadataForMany(this->getAllClassNames());
+	}
 
+	/**
+	 * Returns the names of all classes known to the underlying mapping driver.
+	 *
+	 * @return array
+	 */
+	public function getAllClassNames()
+	{
 		if  !this->initialized {
 			this->initialize();
 		}
 
-		let driver = this->getDriver();
+		return this->getDriver()->getAllClassNames();
+	}
+
+	/**
+	 * Gets the class metadata descriptors for several classes at once.
+	 *
+	 * All the real class names are resolved first, the ones not in memory are
+	 * fetched from the cache with a single multi-get and whatever is still
+	 * missing is loaded and written back with a single multi-save.
+	 *
+	 * @param array classNames
+	 *
+	 * @return array The ClassMetadata instances, in the order of classNames.
+	 */
+	public function getMetadataForMany(array classNames)
+	{
+		var className, realClassName, missing, remaining, key, cached, loadedClassName, toSave, metadata, fetched, fetchStart;
+
+		if this->collectStats === null {
+			let this->collectStats = doctrine_metadata_stats_enabled();
+		}
+
+		// Revalidated entries are checked one by one in getMetadataFor()
+		if this->cacheDriver && !this->revalidateCache {
+			let missing = [];
+			for className in classNames {
+				if isset this->loadedMetadata[className] {
+					continue;
+				}
+				let realClassName = this->getRealClassName(className);
+				if !isset this->loadedMetadata[realClassName] {
+					let missing[realClassName . this->cacheSalt] = realClassName;
+				}
+			}
+
+			// The snapshot answers before the cache is asked for anything
+			if this->snapshot !== null {
+				let remaining = [];
+				for key, realClassName in missing {
+					let cached = doctrine_metadata_snapshot_fetch(this->snapshot, key);
+					if cached !== false {
+						let this->loadedMetadata[realClassName] = cached;
+						this->wakeupReflection(cached, this->getReflectionService());
+						if this->collectStats {
+							doctrine_metadata_stats_record(self::STAT_CACHE_HITS);
+						}
+					} else {
+						let remaining[key] = realClassName;
+					}
+				}
+				let missing = remaining;
+			}
+
+			if count(missing) {
+				if this->collectStats {
+					let fetchStart = doctrine_metadata_stats_clock();
+					let fetched = this->fetchCachedMetadata(array_keys(missing));
+					doctrine_metadata_stats_record(self::STAT_CACHE_FETCH, fetchStart);
+				} else {
+					let fetched = this->fetchCachedMetadata(array_keys(missing));
+				}
+
+				for key, cached in fetched {
+					let this->loadedMetadata[missing[key]] = cached;
+					this->wakeupReflection(cached, this->getReflectionService());
+					if this->collectStats {
+						doctrine_metadata_stats_record(self::STAT_CACHE_HITS);
+					}
+				}
+
+				let toSave = [];
+				for realClassName in missing {
+					// Already there if it was cached or loaded as an ancestor of a previous miss
+					if isset this->loadedMetadata[realClassName] {
+						continue;
+					}
+					if this->collectStats {
+						doctrine_metadata_stats_record(self::STAT_CACHE_MISSES);
+					}
+					for loadedClassName in this->loadMetadata(realClassName) {
+						let toSave[loadedClassName . this->cacheSalt] = this->loadedMetadata[loadedClassName];
+					}
+				}
+
+				if count(toSave) {
+					this->saveCachedMetadata(toSave);
+				}
+			}
+		}
+
 		let metadata = [];
-		for className in driver->getAllClassNames() {
+		for className in classNames {
 			let metadata[] = this->getMetadataFor(className);
 		}
 
 		return metadata;
 	}
 
+	/**
+	 * Fetches several cache entries, using a single multi-get when the cache
+	 * driver supports it. Entries that are not cached are left out.
+	 *
+	 * @param array cacheKeys
+	 *
+	 * @return array
+	 */
+	protected function fetchCachedMetadata(array cacheKeys)
+	{
+		var found, pending, key, cached;
+
+		let found = [];
+		let pending = [];
+		for key in cacheKeys {
+			let cached = doctrine_metadata_store_fetch(key);
+			if cached !== false {
+				let found[key] = cached;
+			} else {
+				let pending[] = key;
+			}
+		}
+
+		if !count(pending) {
+			return found;
+		}
+
+		if this->cacheDriver instanceof MultiGetCache {
+			for key, cached in this->cacheDriver->fetchMultiple(pending) {
+				if cached !== false {
+					let found[key] = cached;
+					doctrine_metadata_store_save(key, cached);
+				}
+			}
+		} else {
+			for key in pending {
+				let cached = this->cacheDriver->{"fetch"}(key);
+				if cached !== false {
+					let found[key] = cached;
+					doctrine_metadata_store_save(key, cached);
+				}
+			}
+		}
+
+		return found;
+	}
+
+	/**
+	 * Saves several cache entries, using a single multi-save when the cache
+	 * driver supports it.
+	 *
+	 * @param array entries ClassMetadata instances indexed by cache key
+	 *
+	 * @return void
+	 */
+	protected function saveCachedMetadata(array entries)
+	{
+		var key, class1;
+
+		if this->cacheDriver instanceof MultiPutCache {
+			this->cacheDriver->saveMultiple(entries, 0);
+		} else {
+			for key, class1 in entries {
+				this->cacheDriver->save(key, class1, null);
+			}
+		}
+
+		for key, class1 in entries {
+			doctrine_metadata_store_save(key, class1);
+		}
+	}
+
 	/**
 	 * Lazy initialization of this stuff, especially the metadata driver,
 	 * since these are not needed at all when a metadata cache is active.
@@ -183,53 +516,375 @@ abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 	 */
 	public function getMetadataFor(className)
 	{
-		var realClassName, list, namespaceAlias, simpleClassName, cached, loadedClassName;
+		var realClassName, cached, start, failure, e;
 
 		if isset this->loadedMetadata[className] {
+			if this->collectStats {
+				doctrine_metadata_stats_record(self::STAT_LOADED_HITS);
+			}
 			return this->loadedMetadata[className];
 		}
 
-		let realClassName = className;
-
-		// Check for namespace alias
-		if strpos(className, ":") !== false {
-			let list = explode(":", className);
-			let namespaceAlias = list[0];
-			let simpleClassName = list[1];
-			let realClassName = this->getFqcnFromAlias(namespaceAlias, simpleClassName);
-		} else {
-			let realClassName = ClassUtils::getRealClass(realClassName);
+		if this->collectStats === null {
+			let this->collectStats = doctrine_metadata_stats_enabled();
 		}
 
+		let realClassName = this->getRealClassName(className);
+
 		if isset this->loadedMetadata[realClassName] {
 			// We do not have the alias name in the map, include it
 			let this->loadedMetadata[className] = this->loadedMetadata[realClassName];
 
+			if this->collectStats {
+				doctrine_metadata_stats_record(self::STAT_LOADED_HITS);
+			}
 			return this->loadedMetadata[realClassName];
 		}
 
-		if this->cacheDriver {
-			let cached = this->cacheDriver->{"fetch"}(realClassName . this->cacheSalt);
+		let start = 0;
+		if this->collectStats {
+			let start = doctrine_metadata_stats_clock();
+		}
+
+		// The local cache holds instances that are already awake, and the
+		// message of the exception thrown for a class that is not mapped as
+		// a negative entry
+		let cached = null;
+		if this->localCache !== null && !this->revalidateCache {
+			let cached = this->localCache->get(realClassName . this->cacheSalt);
+			if cached === null {
+				let failure = this->localCache->get(realClassName . this->cacheSalt . "\\UNMAPPED");
+				if failure !== null {
+					throw new MappingException(failure);
+				}
+			}
+		}
+
+		if cached !== null {
+			let this->loadedMetadata[realClassName] = cached;
+			if this->collectStats {
+				doctrine_metadata_stats_record(self::STAT_LOCAL_CACHE_HITS);
+			}
+		} elseif this->localCache !== null && !this->revalidateCache {
+			try {
+				this->loadMetadataFromCaches(realClassName);
+			} catch \Exception, e {
+				// Only unmapped classes are remembered, other failures may not last
+				if !class_exists(realClassName) || this->isTransient(realClassName) {
+					this->localCache->set(realClassName . this->cacheSalt . "\\UNMAPPED", e->getMessage(), this->negativeCacheTtl);
+				}
+				throw e;
+			}
+
+			this->localCache->set(realClassName . this->cacheSalt, this->loadedMetadata[realClassName]);
+		} else {
+			this->loadMetadataFromCaches(realClassName);
+		}
+
+		if className != realClassName {
+			// We do not have the alias name in the map, include it
+			let this->loadedMetadata[className] = this->loadedMetadata[realClassName];
+		}
+
+		if this->collectStats {
+			doctrine_metadata_stats_record(self::STAT_GET_METADATA_FOR, start);
+		}
+
+		return this->loadedMetadata[className];
+	}
+
+	/**
+	 * Fills loadedMetadata for a class from the snapshot, the process-wide
+	 * store or the cache driver, and loads it when none of them has it.
+	 *
+	 * @param string realClassName
+	 *
+	 * @return void
+	 */
+	protected function loadMetadataFromCaches(realClassName)
+	{
+		var cached, loadedClassName, cacheKey, fetchStart;
+
+		if this->snapshot !== null {
+			let cached = doctrine_metadata_snapshot_fetch(this->snapshot, realClassName . this->cacheSalt);
+		} else {
+			let cached = false;
+		}
+
+		if cached !== false {
+			let this->loadedMetadata[realClassName] = cached;
+			this->wakeupReflection(cached, this->getReflectionService());
+		} elseif this->cacheDriver {
+			// The process-wide store answers first, the cache driver only fills it.
+			// Revalidated entries always come from the cache driver.
+			let cacheKey = realClassName . this->cacheSalt;
+			if this->revalidateCache {
+				let cached = false;
+				if this->isCacheFresh(cacheKey, realClassName) {
+					let cached = this->cacheDriver->{"fetch"}(cacheKey);
+				}
+			} else {
+				// In thread safe builds only the first thread to miss a class
+				// builds it, the others wait for it to be published.
+				let cached = doctrine_metadata_store_fetch(cacheKey);
+				if cached === false && !doctrine_metadata_store_claim(cacheKey) {
+					let cached = doctrine_metadata_store_fetch(cacheKey);
+					if this->collectStats {
+						doctrine_metadata_stats_record(self::STAT_CLAIM_WAITS);
+					}
+				}
+			}
+			if cached === false && !this->revalidateCache {
+				if this->collectStats {
+					let fetchStart = doctrine_metadata_stats_clock();
+					let cached = this->cacheDriver->{"fetch"}(cacheKey);
+					doctrine_metadata_stats_record(self::STAT_CACHE_FETCH, fetchStart);
+				} else {
+					let cached = this->cacheDriver->{"fetch"}(cacheKey);
+				}
+				if cached !== false {
+					doctrine_metadata_store_save(cacheKey, cached);
+				}
+			}
+
 			if cached !== false {
 				let this->loadedMetadata[realClassName] = cached;
 				this->wakeupReflection(cached, this->getReflectionService());
 			} else {
 				for loadedClassName in this->loadMetadata(realClassName) {
-					this->cacheDriver->save(
-						loadedClassName . this->cacheSalt, this->loadedMetadata[loadedClassName], null
-					);
+					let cacheKey = loadedClassName . this->cacheSalt;
+					this->cacheDriver->save(cacheKey, this->loadedMetadata[loadedClassName], null);
+					if this->revalidateCache {
+						this->cacheDriver->save(cacheKey . "\\FILES", this->getFileStamps(loadedClassName), null);
+					} else {
+						doctrine_metadata_store_save(cacheKey, this->loadedMetadata[loadedClassName]);
+					}
 				}
 			}
 		} else {
 			this->loadMetadata(realClassName);
 		}
 
-		if className != realClassName {
-			// We do not have the alias name in the map, include it
-			let this->loadedMetadata[className] = this->loadedMetadata[realClassName];
+		if this->collectStats {
+			if cached !== false {
+				doctrine_metadata_stats_record(self::STAT_CACHE_HITS);
+			} else {
+				doctrine_metadata_stats_record(self::STAT_CACHE_MISSES);
+			}
 		}
+	}
 
-		return this->loadedMetadata[className];
+	/**
+	 * Resolves namespace aliases and proxy class names to the real class name.
+	 *
+	 * @param string className
+	 *
+	 * @return string
+	 */
+	protected function getRealClassName(className)
+	{
+		// Check for namespace alias
+		if strpos(className, ":") !== false {
+			return this->resolveAlias(className);
+		}
+
+		return ClassUtils::getRealClass(className);
+	}
+
+	/**
+	 * Resolves a class name in "Alias:ClassName" notation, each distinct
+	 * alias being split and resolved only once.
+	 *
+	 * @param string className
+	 *
+	 * @return string
+	 */
+	protected function resolveAlias(className)
+	{
+		var list, namespaceAlias, simpleClassName, realClassName;
+
+		if isset this->aliasMap[className] {
+			return this->aliasMap[className];
+		}
+
+		let list = explode(":", className);
+		let namespaceAlias = list[0];
+		let simpleClassName = list[1];
+		let realClassName = this->getFqcnFromAlias(namespaceAlias, simpleClassName);
+		let this->aliasMap[className] = realClassName;
+
+		if this->collectStats {
+			doctrine_metadata_stats_record(self::STAT_ALIAS_RESOLUTIONS);
+		}
+
+		return realClassName;
+	}
+
+	/**
+	 * Enables or disables reporting to doctrine_metadata_stats(). Reporting
+	 * stays off when the counters are not compiled in.
+	 *
+	 * @param bool enabled
+	 *
+	 * @return void
+	 */
+	public function setCollectStats(boolean enabled)
+	{
+		let this->collectStats = enabled && doctrine_metadata_stats_enabled();
+	}
+
+	/**
+	 * Sets a bounded in-process cache consulted before the cache driver. It
+	 * also remembers isTransient() answers, transient ones only for
+	 * negativeTtl seconds, and for as long the exceptions getMetadataFor()
+	 * throws for classes that are not mapped. Only their message is kept,
+	 * later calls throw a new MappingException with it. It may be shared by
+	 * several factories.
+	 *
+	 * @param LocalMetadataCache|null localCache
+	 * @param int negativeTtl
+	 *
+	 * @return void
+	 */
+	public function setLocalCache(<LocalMetadataCache> localCache = null, int negativeTtl = 60)
+	{
+		let this->localCache = localCache;
+		let this->negativeCacheTtl = negativeTtl;
+	}
+
+	/**
+	 * @return LocalMetadataCache|null
+	 */
+	public function getLocalCache()
+	{
+		return this->localCache;
+	}
+
+	/**
+	 * Enables checking cached entries against the modification time and
+	 * inode of the class files (and mapping files) of the class and its
+	 * parents. A changed file only invalidates the classes built from it.
+	 * Meant for development, every miss stats the files involved.
+	 *
+	 * @param bool revalidate
+	 *
+	 * @return void
+	 */
+	public function setCacheRevalidation(boolean revalidate)
+	{
+		let this->revalidateCache = revalidate;
+	}
+
+	/**
+	 * Checks the file stamps saved next to a cached entry.
+	 *
+	 * @param string cacheKey
+	 * @param string className
+	 *
+	 * @return bool
+	 */
+	protected function isCacheFresh(cacheKey, className)
+	{
+		var stamps, file, stamp;
+
+		let stamps = this->cacheDriver->{"fetch"}(cacheKey . "\\FILES");
+		if typeof stamps != "array" {
+			return false;
+		}
+
+		for file, stamp in stamps {
+			if this->statFile(file) !== stamp {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * Returns the stamps of the files a class is built from: its own class
+	 * file, those of its parents and, for file drivers, their mapping files.
+	 *
+	 * ClassMetadata::getFile() cannot be used for this, in the ODM it is the
+	 * GridFS file field of the document.
+	 *
+	 * @param string className
+	 *
+	 * @return array
+	 */
+	protected function getFileStamps(className)
+	{
+		var reflService, driver, locator, names, name, reflClass, file, files, stamps, found;
+
+		if  !this->initialized {
+			this->initialize();
+		}
+
+		let reflService = this->getReflectionService();
+		let driver = this->getDriver();
+		let locator = null;
+		if method_exists(driver, "getLocator") {
+			let locator = driver->getLocator();
+		}
+
+		let names = array_values(reflService->getParentClasses(className));
+		let names[] = className;
+
+		let files = [];
+		for name in names {
+			let reflClass = reflService->getClass(name);
+			if reflClass {
+				let file = reflClass->getFileName();
+				if file {
+					let files[file] = true;
+				}
+			}
+			if locator && locator->fileExists(name) {
+				let files[locator->findMappingFile(name)] = true;
+			}
+		}
+
+		let stamps = [];
+		for file, found in files {
+			let stamps[file] = this->statFile(file);
+		}
+
+		return stamps;
+	}
+
+	/**
+	 * Stats a file once per factory.
+	 *
+	 * @param string file
+	 *
+	 * @return array|bool The modification time and inode, FALSE if the file is gone
+	 */
+	protected function statFile(file)
+	{
+		var stat;
+
+		if isset this->fileStats[file] {
+			return this->fileStats[file];
+		}
+
+		let stat = false;
+		if is_file(file) {
+			let stat = stat(file);
+			let stat = [stat["mtime"], stat["ino"]];
+		}
+		let this->fileStats[file] = stat;
+
+		return stat;
+	}
+
+	/**
+	 * Forgets the resolved namespace aliases.
+	 *
+	 * @return void
+	 */
+	public function clearAliasCache()
+	{
+		let this->aliasMap = [];
 	}
 
 	/**
@@ -268,15 +923,38 @@ abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 	 */
 	protected function getParentClasses(name)
 	{
-		var parentClasses, parentClass;
+		var parentClasses, parentClass, cacheKey;
+
+		if isset this->parentClassesCache[name] {
+			return this->parentClassesCache[name];
+		}
+
+		if this->cacheDriver && !this->revalidateCache {
+			let cacheKey = name . this->cacheSalt . "\\PARENTS";
+			let parentClasses = doctrine_metadata_store_fetch(cacheKey);
+			if typeof parentClasses == "array" {
+				let this->parentClassesCache[name] = parentClasses;
+				return parentClasses;
+			}
+		}
 
 		// Collect parent classes, ignoring transient (not-mapped) classes.
+		// The chain of the direct parent is cached as well, so siblings
+		// only check their own parent with the driver.
 		let parentClasses = [];
-		for parentClass in reverse this->getReflectionService()->getParentClasses(name) {
+		for parentClass in this->getReflectionService()->getParentClasses(name) {
+			let parentClasses = this->getParentClasses(parentClass);
 			if  !this->getDriver()->isTransient(parentClass) {
 				let parentClasses[] = parentClass;
 			}
+			break;
 		}
+
+		let this->parentClassesCache[name] = parentClasses;
+		if this->cacheDriver && !this->revalidateCache {
+			doctrine_metadata_store_save(cacheKey, parentClasses);
+		}
+
 		return parentClasses;
 	}
 
@@ -297,12 +975,17 @@ abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 	protected function loadMetadata(name)
 	{
 		var loaded, parentClasses, parent, rootEntityFound, visited, reflService, className,
-			class1;
+			class1, start, classStart;
 
 		if  ! this->initialized {
 			this->initialize();
 		}
 
+		let start = 0;
+		if this->collectStats {
+			let start = doctrine_metadata_stats_clock();
+		}
+
 		let loaded = [];
 
 		let parentClasses = this->getParentClasses(name);
@@ -313,7 +996,9 @@ abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 
 		//var_dump(parentClasses);
 
-		// Move down the hierarchy of parent classes, starting from the topmost class
+		// Move down the hierarchy of parent classes, starting from the topmost class.
+		// Visited entity classes are appended, doLoadMetadata() gets them
+		// nearest first as before.
 		let parent = null;
 		let rootEntityFound = false;
 		let visited = [];
@@ -325,7 +1010,7 @@ abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 				let parent = this->loadedMetadata[className];
 				if this->isEntity(parent) {
 					let rootEntityFound = true;
-					array_unshift(visited, className);
+					let visited[] = className;
 				}
 				continue;
 			}
@@ -336,7 +1021,13 @@ abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 
 			//var_dump(className);
 
-			this->doLoadMetadata(class1, parent, rootEntityFound, visited);
+			if this->collectStats {
+				let classStart = doctrine_metadata_stats_clock();
+				this->doLoadMetadata(class1, parent, rootEntityFound, array_reverse(visited));
+				doctrine_metadata_stats_record(self::STAT_DO_LOAD_METADATA, classStart);
+			} else {
+				this->doLoadMetadata(class1, parent, rootEntityFound, array_reverse(visited));
+			}
 			let this->loadedMetadata[className] = class1;
 			//var_dump(this->loadedMetadata);
 
@@ -344,7 +1035,7 @@ abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 
 			if this->isEntity(class1) {
 				let rootEntityFound = true;
-				array_unshift(visited, className);
+				let visited[] = className;
 			}
 
 			this->wakeupReflection(class1, reflService);
@@ -352,7 +1043,9 @@ abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 			let loaded[] = className;
 		}
 
-
+		if this->collectStats {
+			doctrine_metadata_stats_record(self::STAT_LOAD_METADATA, start);
+		}
 
 		return loaded;
 	}
@@ -364,7 +1057,8 @@ abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 	 * @param ClassMetadata|null parent
 	 * @param bool               rootEntityFound
 	 * @param array              nonSuperclassParents All parent class names
-	 *                                                 that are not marked as mapped superclasses.
+	 *                                                 that are not marked as mapped superclasses,
+	 *                                                 nearest first.
 	 *
 	 * @return void
 	 */
@@ -384,7 +1078,7 @@ abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 	 */
 	public function isTransient(class1)
 	{
-		var list, namespaceAlias, simpleClassName;
+		var key, transient;
 
 		if  ! this->initialized {
 			this->initialize();
@@ -392,13 +1086,26 @@ abstract class AbstractClassMetadataFactory implements ClassMetadataFactory
 
 		// Check for namespace alias
 		if strpos(class1, ":") !== false {
-			let list = explode(":", class1);
-			let namespaceAlias = list[0];
-			let simpleClassName = list[1];
-			let class1 = this->getFqcnFromAlias(namespaceAlias, simpleClassName);
+			let class1 = this->resolveAlias(class1);
+		}
+
+		if this->localCache === null {
+			return this->getDriver()->isTransient(class1);
+		}
+
+		// Transient answers are negative entries, they expire
+		let key = class1 . this->cacheSalt . "\\TRANSIENT";
+		let transient = this->localCache->get(key);
+		if transient === null {
+			let transient = (bool) this->getDriver()->isTransient(class1);
+			if transient {
+				this->localCache->set(key, true, this->negativeCacheTtl);
+			} else {
+				this->localCache->set(key, false);
+			}
 		}
 
-		return this->getDriver()->isTransient(class1);
+		return transient;
 	}
 
 	/**
@@ -0,0 +1,251 @@
+/*
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This software consists of voluntary contributions made by many individuals
+ * and is licensed under the MIT license. For more information, see
+ * <http://www.doctrine-project.org>.
+ */
+
+namespace Doctrine\Common\Persistence\Mapping;
+
+/**
+ * Bounded in-process cache placed in front of the cache driver of one or
+ * more metadata factories.
+ *
+ * Entries live in a fixed number of slots and are evicted with the CLOCK
+ * algorithm: every hit sets the reference bit of the slot, and the hand
+ * clears bits until it finds an unreferenced slot to reuse. Entries can
+ * expire, which the factories use for negative results such as transient
+ * classes, so a long running process never holds more than the capacity.
+ *
+ * @since  2.2
+ */
+class LocalMetadataCache
+{
+	/**
+	 * @var int
+	 */
+	protected capacity;
+
+	/**
+	 * Slot of each key.
+	 *
+	 * @var array
+	 */
+	protected index = [];
+
+	/**
+	 * Key, value, expiry time (0 for none) and reference bit of each slot.
+	 *
+	 * @var array
+	 */
+	protected keys = [];
+	protected values = [];
+	protected expires = [];
+	protected referenced = [];
+
+	/**
+	 * Slots emptied by remove() or expiry, used as a stack.
+	 *
+	 * @var array
+	 */
+	protected freeSlots = [];
+	protected freeCount = 0;
+
+	/**
+	 * @var int
+	 */
+	protected hand = 0;
+
+	/**
+	 * @var int
+	 */
+	protected hits = 0;
+	protected misses = 0;
+	protected evictions = 0;
+	protected expirations = 0;
+
+	/**
+	 * @param int capacity
+	 */
+	public function __construct(int capacity = 1024)
+	{
+		if capacity < 1 {
+			let capacity = 1;
+		}
+		let this->capacity = capacity;
+	}
+
+	/**
+	 * Returns an entry, or null when it is missing or expired.
+	 *
+	 * @param string key
+	 *
+	 * @return mixed
+	 */
+	public function get(string key)
+	{
+		var slot, expires;
+
+		if !isset this->index[key] {
+			let this->misses++;
+			return null;
+		}
+
+		let slot = this->index[key];
+		let expires = this->expires[slot];
+		if expires && expires < time() {
+			this->removeSlot(slot);
+			let this->expirations++;
+			let this->misses++;
+			return null;
+		}
+
+		let this->referenced[slot] = true;
+		let this->hits++;
+
+		return this->values[slot];
+	}
+
+	/**
+	 * Stores an entry, evicting another one when the cache is full.
+	 *
+	 * @param string key
+	 * @param mixed  value Anything but null
+	 * @param int    ttl   Lifetime in seconds, 0 for none
+	 *
+	 * @return void
+	 */
+	public function set(string key, value, int ttl = 0)
+	{
+		var slot;
+
+		if isset this->index[key] {
+			let slot = this->index[key];
+		} else {
+			let slot = this->findFreeSlot();
+			let this->index[key] = slot;
+			let this->keys[slot] = key;
+		}
+
+		let this->values[slot] = value;
+		let this->referenced[slot] = false;
+		if ttl > 0 {
+			let this->expires[slot] = time() + ttl;
+		} else {
+			let this->expires[slot] = 0;
+		}
+	}
+
+	/**
+	 * Removes an entry.
+	 *
+	 * @param string key
+	 *
+	 * @return void
+	 */
+	public function remove(string key)
+	{
+		if isset this->index[key] {
+			this->removeSlot(this->index[key]);
+		}
+	}
+
+	/**
+	 * Removes all entries, the statistics are kept.
+	 *
+	 * @return void
+	 */
+	public function clear()
+	{
+		let this->index = [];
+		let this->keys = [];
+		let this->values = [];
+		let this->expires = [];
+		let this->referenced = [];
+		let this->freeSlots = [];
+		let this->freeCount = 0;
+		let this->hand = 0;
+	}
+
+	/**
+	 * Returns the hit, miss, eviction and expiration counts.
+	 *
+	 * @return array
+	 */
+	public function getStats()
+	{
+		return [
+			"hits": this->hits,
+			"misses": this->misses,
+			"evictions": this->evictions,
+			"expirations": this->expirations,
+			"size": count(this->index),
+			"capacity": this->capacity
+		];
+	}
+
+	/**
+	 * Returns an unused slot, evicting the first unreferenced entry the
+	 * hand comes across when all of them are in use.
+	 *
+	 * @return int
+	 */
+	protected function findFreeSlot()
+	{
+		var slot;
+
+		if this->freeCount {
+			let this->freeCount--;
+			return this->freeSlots[this->freeCount];
+		}
+
+		let slot = count(this->keys);
+		if slot < this->capacity {
+			return slot;
+		}
+
+		loop {
+			let slot = this->hand;
+			let this->hand = (slot + 1) % this->capacity;
+			if !this->referenced[slot] {
+				break;
+			}
+			let this->referenced[slot] = false;
+		}
+
+		this->removeSlot(slot);
+		let this->evictions++;
+		let this->freeCount--;
+
+		return slot;
+	}
+
+	/**
+	 * @param int slot
+	 */
+	protected function removeSlot(slot)
+	{
+		var key;
+
+		let key = this->keys[slot];
+		unset(this->index[key]);
+		unset(this->keys[slot]);
+		unset(this->values[slot]);
+		unset(this->expires[slot]);
+		unset(this->referenced[slot]);
+
+		let this->freeSlots[this->freeCount] = slot;
+		let this->freeCount++;
+	}
+}
@@ -38,16 +38,8 @@ class ClassUtils
      */
     public static function getRealClass(class1)
     {
-        var pos, a;
-        
-        //let pos = strrpos(class1, "\\" . Proxy::MARKER . "\\");
-        let pos = strrpos(class1, "\\" . "__CG__" . "\\");
-        if (false === pos) {
-            return class1;
-        }
-        //let a = pos + Proxy::MARKER_LENGTH + 2;
-        let a = pos + 6 + 2;
-        return substr(class1, a);
+        // Resolved names are memoized per process by the extension
+        return doctrine_get_real_class(class1);
     }
 
     /**
@@ -0,0 +1,173 @@
+/*
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This software consists of voluntary contributions made by many individuals
+ * and is licensed under the MIT license. For more information, see
+ * <http://www.doctrine-project.org>.
+ */
+
+namespace Doctrine\ODM\MongoDB;
+
+/**
+ * Event manager that keeps one bit per ODM event telling whether the event
+ * has any listener, so hot paths can skip a dispatch by testing the bit.
+ *
+ * DocumentManager::create() still defaults to the Common EventManager, so
+ * the bits are only used when this one is passed to it explicitly.
+ *
+ * @since       1.0
+ */
+class EventManager extends \Doctrine\Common\EventManager
+{
+    const PRE_REMOVE = 1;
+    const POST_REMOVE = 2;
+    const PRE_PERSIST = 4;
+    const POST_PERSIST = 8;
+    const PRE_UPDATE = 16;
+    const POST_UPDATE = 32;
+    const PRE_LOAD = 64;
+    const POST_LOAD = 128;
+    const LOAD_CLASS_METADATA = 256;
+    const PRE_FLUSH = 512;
+    const ON_FLUSH = 1024;
+    const POST_FLUSH = 2048;
+    const ON_CLEAR = 4096;
+    const DOCUMENT_NOT_FOUND = 8192;
+    const PRE_UPSERT = 16384;
+    const POST_UPSERT = 32768;
+
+    /**
+     * Bits of the events that currently have listeners.
+     *
+     * @var int
+     */
+    protected listenerMask = 0;
+
+    /**
+     * Returns the bits of the events that currently have listeners, to be
+     * tested against the event constants.
+     *
+     * @return int
+     */
+    public function getListenerMask() -> int
+    {
+        return this->listenerMask;
+    }
+
+    /**
+     * Returns the bit of an ODM event, or 0 for any other event.
+     *
+     * @param string event
+     * @return int
+     */
+    public static function getEventBit(string event) -> int
+    {
+        switch event {
+            case "preRemove":
+                return self::PRE_REMOVE;
+            case "postRemove":
+                return self::POST_REMOVE;
+            case "prePersist":
+                return self::PRE_PERSIST;
+            case "postPersist":
+                return self::POST_PERSIST;
+            case "preUpdate":
+                return self::PRE_UPDATE;
+            case "postUpdate":
+                return self::POST_UPDATE;
+            case "preLoad":
+                return self::PRE_LOAD;
+            case "postLoad":
+                return self::POST_LOAD;
+            case "loadClassMetadata":
+                return self::LOAD_CLASS_METADATA;
+            case "preFlush":
+                return self::PRE_FLUSH;
+            case "onFlush":
+                return self::ON_FLUSH;
+            case "postFlush":
+                return self::POST_FLUSH;
+            case "onClear":
+                return self::ON_CLEAR;
+            case "documentNotFound":
+                return self::DOCUMENT_NOT_FOUND;
+            case "preUpsert":
+                return self::PRE_UPSERT;
+            case "postUpsert":
+                return self::POST_UPSERT;
+        }
+
+        return 0;
+    }
+
+    /**
+     * {@inheritDoc}
+     */
+    public function hasListeners(event)
+    {
+        var bit;
+
+        let bit = self::getEventBit(event);
+        if bit {
+            return (this->listenerMask & bit) != 0;
+        }
+
+        return parent::hasListeners(event);
+    }
+
+    /**
+     * {@inheritDoc}
+     */
+    public function addEventListener(events, listener)
+    {
+        parent::addEventListener(events, listener);
+        this->updateListenerMask(events);
+    }
+
+    /**
+     * {@inheritDoc}
+     */
+    public function removeEventListener(events, listener)
+    {
+        parent::removeEventListener(events, listener);
+        this->updateListenerMask(events);
+    }
+
+    /**
+     * Recomputes the bits of the given events from the registered listeners.
+     * Subscribers are covered too, since the parent registers them through
+     * addEventListener() and removeEventListener().
+     *
+     * @param string|array events
+     */
+    protected function updateListenerMask(events)
+    {
+        var event, bit;
+
+        if typeof events != "array" {
+            let events = [events];
+        }
+
+        for event in events {
+            let bit = self::getEventBit(event);
+            if !bit {
+                continue;
+            }
+            if parent::hasListeners(event) {
+                let this->listenerMask = this->listenerMask | bit;
+            } else {
+                let this->listenerMask = this->listenerMask & ~bit;
+            }
+        }
+    }
+}
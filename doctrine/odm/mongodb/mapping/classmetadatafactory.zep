@@ -23,8 +23,11 @@ use Doctrine\Common\Persistence\Mapping\ClassMetadata as ClassMetadataInterface;
 use Doctrine\Common\Persistence\Mapping\ReflectionService;
 use Doctrine\ODM\MongoDB\Configuration;
 use Doctrine\ODM\MongoDB\DocumentManager;
+use Doctrine\ODM\MongoDB\EventManager;
 use Doctrine\ODM\MongoDB\Events;
 use Doctrine\ODM\MongoDB\Mapping\ClassMetadata;
+use Doctrine\ODM\MongoDB\Mapping\DiscriminatorIndex;
+use Doctrine\ODM\MongoDB\Mapping\FieldMappingTable;
 use Doctrine\ODM\MongoDB\Mapping\MappingException;
 
 /**
@@ -52,6 +55,24 @@ class ClassMetadataFactory extends AbstractClassMetadataFactory
     /** @var \Doctrine\Common\EventManager The event manager instance */
     private evm;
 
+    /** @var bool Whether the event manager keeps a listener bitmask */
+    private evmHasListenerMask = false;
+
+    /** @var array FieldMappingTable instances indexed by class name */
+    private fieldMappingTables = [];
+
+    /** @var array Configured custom id generators indexed by class and options */
+    private idGeneratorPrototypes = [];
+
+    /** @var array DiscriminatorIndex instances indexed by root document name */
+    private discriminatorIndexes = [];
+
+    /** @var array Prepared inherited mappings indexed by parent class name */
+    private inheritedMappings = [];
+
+    /** @var array|null The document namespaces the alias cache was built with */
+    private aliasNamespaces = null;
+
     /**
      * Sets the DocumentManager instance for this class.
      *
@@ -70,6 +91,58 @@ class ClassMetadataFactory extends AbstractClassMetadataFactory
     public function setConfiguration(<Configuration> config)
     {
         let this->config = config;
+        this->clearAliasCache();
+    }
+
+    /**
+     * Returns the compact field lookup table of a class, built the first time
+     * it is asked for. Hydration and persistence code can query the mapping
+     * of a field through it without reading the fieldMappings array.
+     *
+     * @param string className
+     * @return FieldMappingTable
+     */
+    public function getFieldMappingTable(className)
+    {
+        var class1, table;
+
+        if isset this->fieldMappingTables[className] {
+            return this->fieldMappingTables[className];
+        }
+
+        let class1 = this->getMetadataFor(className);
+        let table = new FieldMappingTable(class1->fieldMappings);
+        let this->fieldMappingTables[className] = table;
+
+        return table;
+    }
+
+    /**
+     * Returns the discriminator index of the hierarchy of a class, or null
+     * when the class has no discriminator map.
+     *
+     * @param string className
+     * @return DiscriminatorIndex|null
+     */
+    public function getDiscriminatorIndex(className)
+    {
+        var class1;
+
+        let class1 = this->getMetadataFor(className);
+        if !class1->discriminatorMap {
+            return null;
+        }
+
+        return this->getRootDiscriminatorIndex(class1);
+    }
+
+    /**
+     * {@inheritDoc}
+     */
+    public function setMetadataFor(className, class1)
+    {
+        unset(this->fieldMappingTables[className]);
+        parent::setMetadataFor(className, class1);
     }
 
     /**
@@ -80,6 +153,7 @@ class ClassMetadataFactory extends AbstractClassMetadataFactory
     {
         let this->driver = this->config->getMetadataDriverImpl();
         let this->evm = this->dm->getEventManager();
+        let this->evmHasListenerMask = this->evm instanceof EventManager;
         let this->initialized = true;
     }
 
@@ -88,9 +162,38 @@ class ClassMetadataFactory extends AbstractClassMetadataFactory
      */
     protected function getFqcnFromAlias(namespaceAlias, simpleClassName)
     {
+        var namespaces;
+
+        // Only called when the alias cache misses, so hits never read the
+        // configuration. Aliases resolved with other namespaces are dropped.
+        let namespaces = this->config->getDocumentNamespaces();
+        if namespaces !== this->aliasNamespaces {
+            if this->aliasNamespaces !== null {
+                parent::clearAliasCache();
+            }
+            let this->aliasNamespaces = namespaces;
+        }
+
+        if isset namespaces[namespaceAlias] {
+            return namespaces[namespaceAlias] . "\\" . simpleClassName;
+        }
+
+        // Unknown, it throws
         return this->config->getDocumentNamespace(namespaceAlias) . "\\" . simpleClassName;
     }
 
+    /**
+     * Forgets the resolved aliases and the document namespaces they were
+     * resolved with.
+     *
+     * @return void
+     */
+    public function clearAliasCache()
+    {
+        let this->aliasNamespaces = null;
+        parent::clearAliasCache();
+    }
+
     /**
      * {@inheritDoc}
      */
@@ -126,14 +229,16 @@ class ClassMetadataFactory extends AbstractClassMetadataFactory
      */
     protected function doLoadMetadata(class1, parent, rootEntityFound, array nonSuperclassParents = [])
     {
-        var eventArgs;
+        var eventArgs, hasListeners;
 
         /** @var class ClassMetadata */
         /** @var parent ClassMetadata */
         if parent {
             class1->setInheritanceType(parent->inheritanceType);
             class1->setDiscriminatorField(parent->discriminatorField);
-            class1->setDiscriminatorMap(parent->discriminatorMap);
+            if parent->discriminatorMap {
+                this->addInheritedDiscriminatorMap(class1, parent);
+            }
             class1->setIdGeneratorType(parent->generatorType);
             this->addInheritedFields(class1, parent);
             this->addInheritedIndexes(class1, parent);
@@ -179,7 +284,13 @@ class ClassMetadataFactory extends AbstractClassMetadataFactory
 
         class1->setParentClasses(nonSuperclassParents);
 
-        if this->evm->hasListeners("loadClassMetadata") {
+        if this->evmHasListenerMask {
+            let hasListeners = (this->evm->getListenerMask() & EventManager::LOAD_CLASS_METADATA) != 0;
+        } else {
+            let hasListeners = this->evm->hasListeners("loadClassMetadata");
+        }
+
+        if hasListeners {
             let eventArgs = new \Doctrine\ODM\MongoDB\Event\LoadClassMetadataEventArgs(class1, this->dm);
             this->evm->dispatchEvent("loadClassMetadata", eventArgs);
         }
@@ -211,8 +322,8 @@ class ClassMetadataFactory extends AbstractClassMetadataFactory
 
     private function completeIdGeneratorMapping(<ClassMetadataInfo> class1)
     {
-        var idGenOptions, incrementGenerator, uuidGenerator, alnumGenerator, customGenerator, methods,
-            name, value, method, x;
+        var idGenOptions, incrementGenerator, uuidGenerator, alnumGenerator, customGenerator,
+            name, value, method, x, key;
 
         let idGenOptions = class1->generatorOptions;
         switch class1->generatorType {
@@ -261,22 +372,31 @@ class ClassMetadataFactory extends AbstractClassMetadataFactory
                 }
 
                 let x = idGenOptions["class"];
-                let customGenerator = new {x}();
                 unset(idGenOptions["class"]);
+
+                // Classes sharing a generator configuration get clones of one prototype
+                let key = x . "|" . serialize(idGenOptions);
+                if isset this->idGeneratorPrototypes[key] {
+                    class1->setIdGenerator(clone this->idGeneratorPrototypes[key]);
+                    break;
+                }
+
+                let customGenerator = new {x}();
                 if  ! (customGenerator instanceof \Doctrine\ODM\MongoDB\Id\AbstractIdGenerator) {
                     //throw MappingException::classIsNotAValidGenerator(get_class(customGenerator));
                 }
 
-                let methods = get_class_methods(customGenerator);
                 for name, value in idGenOptions {
                     let method = "set" . ucfirst(name);
-                    if  ! in_array(method, methods) {
-                        //throw MappingException::missingGeneratorSetter(get_class(customGenerator), name);
-                    }
+                    //if  ! method_exists(customGenerator, method) {
+                    //    throw MappingException::missingGeneratorSetter(get_class(customGenerator), name);
+                    //}
 
-                    customGenerator->method(value);
+                    customGenerator->{method}(value);
                 }
-                class1->setIdGenerator(customGenerator);
+
+                let this->idGeneratorPrototypes[key] = customGenerator;
+                class1->setIdGenerator(clone customGenerator);
                 break;
             case 6://ClassMetadata::GENERATOR_TYPE_NONE:
                 break;
@@ -286,27 +406,126 @@ class ClassMetadataFactory extends AbstractClassMetadataFactory
         }
     }
 
+    /**
+     * Gives a subclass the discriminator map of its parent without calling
+     * setDiscriminatorMap(), which checks every class of the hierarchy again
+     * for every subclass. The map is shared, the discriminator value and the
+     * subclasses come from the index of the root.
+     *
+     * @param ClassMetadata subClass
+     * @param ClassMetadata parentClass
+     */
+    private function addInheritedDiscriminatorMap(<ClassMetadata> subClass, <ClassMetadata> parentClass)
+    {
+        var index, className;
+
+        let index = this->getRootDiscriminatorIndex(parentClass);
+
+        // A class between the root and the parent extended or changed the map
+        if index->getMap() !== parentClass->discriminatorMap {
+            subClass->setDiscriminatorMap(parentClass->discriminatorMap);
+            return;
+        }
+
+        let className = subClass->name;
+        let subClass->discriminatorMap = parentClass->discriminatorMap;
+        let subClass->discriminatorValue = index->getValue(className);
+        let subClass->subClasses = index->getSubClasses(className);
+    }
+
+    /**
+     * @param ClassMetadata class
+     * @return DiscriminatorIndex
+     */
+    private function getRootDiscriminatorIndex(<ClassMetadata> class1)
+    {
+        var rootName, index;
+
+        let rootName = class1->rootDocumentName;
+        if isset this->discriminatorIndexes[rootName] {
+            return this->discriminatorIndexes[rootName];
+        }
+
+        let index = new DiscriminatorIndex(class1->discriminatorMap);
+        let this->discriminatorIndexes[rootName] = index;
+
+        return index;
+    }
+
     /**
      * Adds inherited fields to the subclass mapping.
      *
+     * A subclass that has no mappings of its own yet gets the prepared
+     * arrays of its parent assigned as a whole, so all siblings share the
+     * same storage until the driver adds or overrides a field.
+     *
      * @param ClassMetadata subClass
      * @param ClassMetadata parentClass
      */
     private function addInheritedFields(<ClassMetadata> subClass, <ClassMetadata> parentClass)
     {
-        var fieldName, mapping, name, field;
+        var inherited, mapping, name, field;
+
+        let inherited = this->getInheritedMappings(parentClass);
+
+        if empty subClass->fieldMappings {
+            let subClass->fieldMappings = inherited[1];
+            if count(inherited[2]) {
+                let subClass->associationMappings = inherited[2];
+            }
+        } else {
+            for mapping in inherited[1] {
+                subClass->addInheritedFieldMapping(mapping);
+            }
+        }
+
+        if empty subClass->reflFields {
+            let subClass->reflFields = parentClass->reflFields;
+        } else {
+            for name, field in parentClass->reflFields {
+                let subClass->reflFields[name] = field;
+            }
+        }
+    }
+
+    /**
+     * Returns the field and association mappings a parent passes on to its
+     * subclasses, prepared once per parent.
+     *
+     * @param ClassMetadata parentClass
+     * @return array The parent, its field mappings and its association mappings
+     */
+    private function getInheritedMappings(<ClassMetadata> parentClass)
+    {
+        var name, inherited, fieldMappings, associationMappings, fieldName, mapping;
+
+        let name = parentClass->name;
+        if isset this->inheritedMappings[name] {
+            let inherited = this->inheritedMappings[name];
+            if inherited[0] === parentClass {
+                return inherited;
+            }
+        }
+
+        let fieldMappings = [];
+        let associationMappings = [];
         for fieldName, mapping in parentClass->fieldMappings {
             if  ! isset mapping["inherited"] && ! parentClass->isMappedSuperclass {
-                let mapping["inherited"] = parentClass->name;
+                let mapping["inherited"] = name;
             }
             if  ! isset mapping["declared"] {
-                let mapping["declared"] = parentClass->name;
+                let mapping["declared"] = name;
+            }
+            let fieldMappings[fieldName] = mapping;
+            if isset mapping["association"] {
+                let associationMappings[fieldName] = mapping;
             }
-            subClass->addInheritedFieldMapping(mapping);
-        }
-        for name, field in parentClass->reflFields {
-            let subClass->reflFields[name] = field;
         }
+
+        let inherited = [parentClass, fieldMappings, associationMappings];
+        let this->inheritedMappings[name] = inherited;
+
+        return inherited;
     }
 
     /**
@@ -318,6 +537,14 @@ class ClassMetadataFactory extends AbstractClassMetadataFactory
     private function addInheritedIndexes(<ClassMetadata> subClass, <ClassMetadata> parentClass)
     {
         var index;
+
+        // The parent's indexes went through addIndex() already, a subclass
+        // without indexes of its own shares the parent's array
+        if empty subClass->indexes {
+            let subClass->indexes = parentClass->indexes;
+            return;
+        }
+
         for index in parentClass->indexes {
             subClass->addIndex(index["keys"], index["options"]);
         }
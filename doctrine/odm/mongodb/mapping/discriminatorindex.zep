@@ -0,0 +1,113 @@
+/*
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This software consists of voluntary contributions made by many individuals
+ * and is licensed under the MIT license. For more information, see
+ * <http://www.doctrine-project.org>.
+ */
+
+
+namespace Doctrine\ODM\MongoDB\Mapping;
+
+/**
+ * Both directions of the discriminator map of an inheritance hierarchy,
+ * built once per root document and shared by the ClassMetadataFactory
+ * between all of its subclasses.
+ *
+ * @since       1.0
+ */
+class DiscriminatorIndex
+{
+    /** @var array Discriminator value => class name */
+    protected classNames;
+
+    /** @var array Class name => discriminator value */
+    protected values = [];
+
+    /** @var array Class name => mapped subclasses, in discriminator map order */
+    protected subClasses = [];
+
+    /**
+     * @param array discriminatorMap The resolved discriminator map of the root
+     */
+    public function __construct(array discriminatorMap)
+    {
+        var value, className, parentClassName;
+
+        let this->classNames = discriminatorMap;
+
+        for value, className in discriminatorMap {
+            let this->values[className] = value;
+        }
+
+        // The ancestors of every mapped class, mapped or not, get it as a
+        // subclass, as ClassMetadataInfo::setDiscriminatorMap() would do
+        // with is_subclass_of() for each of them
+        for className in discriminatorMap {
+            for parentClassName in class_parents(className) {
+                let this->subClasses[parentClassName][] = className;
+            }
+        }
+    }
+
+    /**
+     * @return array
+     */
+    public function getMap()
+    {
+        return this->classNames;
+    }
+
+    /**
+     * Returns the class of a discriminator value, as used on hydration.
+     *
+     * @param string value
+     * @return string|null
+     */
+    public function getClassName(value)
+    {
+        if isset this->classNames[value] {
+            return this->classNames[value];
+        }
+
+        return null;
+    }
+
+    /**
+     * Returns the discriminator value of a class, as used on persist.
+     *
+     * @param string className
+     * @return string|null
+     */
+    public function getValue(string className)
+    {
+        if isset this->values[className] {
+            return this->values[className];
+        }
+
+        return null;
+    }
+
+    /**
+     * @param string className
+     * @return array
+     */
+    public function getSubClasses(string className)
+    {
+        if isset this->subClasses[className] {
+            return this->subClasses[className];
+        }
+
+        return [];
+    }
+}
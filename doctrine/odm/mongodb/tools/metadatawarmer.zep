@@ -0,0 +1,320 @@
+/*
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This software consists of voluntary contributions made by many individuals
+ * and is licensed under the MIT license. For more information, see
+ * <http://www.doctrine-project.org>.
+ */
+
+namespace Doctrine\ODM\MongoDB\Tools;
+
+use Doctrine\Common\Persistence\Mapping\AbstractClassMetadataFactory;
+
+/**
+ * Loads the metadata of all mapped classes in forked workers, to fill the
+ * metadata cache or write a metadata snapshot right after a deploy.
+ *
+ * Classes are partitioned by hierarchy root, so a root and its subclasses
+ * are loaded by the same worker and no parent is loaded twice. A worker
+ * that dies on a mapping error stops the whole run.
+ *
+ * Without the pcntl extension, or with a single worker, the classes are
+ * loaded in the current process.
+ *
+ * @since       1.0
+ */
+class MetadataWarmer
+{
+    /** @var AbstractClassMetadataFactory */
+    private metadataFactory;
+
+    /** @var int */
+    private workers;
+
+    /** @var string Directory the workers write their results to */
+    private tmpDir;
+
+    /**
+     * @param AbstractClassMetadataFactory metadataFactory
+     * @param int workers
+     * @param string|null tmpDir
+     */
+    public function __construct(<AbstractClassMetadataFactory> metadataFactory, int workers = 4, tmpDir = null)
+    {
+        if workers < 1 {
+            let workers = 1;
+        }
+        if tmpDir === null {
+            let tmpDir = sys_get_temp_dir();
+        }
+
+        let this->metadataFactory = metadataFactory;
+        let this->workers = workers;
+        let this->tmpDir = tmpDir;
+    }
+
+    /**
+     * Loads all classes and saves them to the cache driver of the factory.
+     *
+     * @return array One entry per worker with its pid, classes and seconds
+     */
+    public function warmCache()
+    {
+        var result;
+
+        let result = this->run(false);
+        return result[0];
+    }
+
+    /**
+     * Loads all classes and writes them to a metadata snapshot.
+     *
+     * @param string path
+     * @param string version
+     * @return array One entry per worker with its pid, classes and seconds
+     */
+    public function warmSnapshot(string path, string version)
+    {
+        var result;
+
+        let result = this->run(true);
+        if !this->metadataFactory->writeMetadataSnapshot(path, version, result[1]) {
+            throw new \RuntimeException("Unable to write the metadata snapshot " . path);
+        }
+
+        return result[0];
+    }
+
+    /**
+     * Splits class names into at most one partition per worker, each
+     * hierarchy going whole to the least loaded partition.
+     *
+     * @param array classNames
+     * @return array
+     */
+    public function getPartitions(array classNames)
+    {
+        var reflService, known, groups, group, className, parentClass, root,
+            partitions, loads, load, target, i;
+
+        let reflService = this->metadataFactory->getReflectionService();
+        let known = array_flip(classNames);
+
+        // Parents come nearest first, the last mapped one is the root
+        let groups = [];
+        for className in classNames {
+            let root = className;
+            for parentClass in reflService->getParentClasses(className) {
+                if isset known[parentClass] {
+                    let root = parentClass;
+                }
+            }
+
+            if isset groups[root] {
+                let group = groups[root];
+            } else {
+                let group = [];
+            }
+            let group[] = className;
+            let groups[root] = group;
+        }
+
+        let partitions = [];
+        let loads = [];
+        for i in range(0, this->workers - 1) {
+            let partitions[i] = [];
+            let loads[i] = 0;
+        }
+
+        for group in groups {
+            let target = 0;
+            for i, load in loads {
+                if load < loads[target] {
+                    let target = i;
+                }
+            }
+            let partitions[target] = array_merge(partitions[target], group);
+            let loads[target] = loads[target] + count(group);
+        }
+
+        let groups = [];
+        for group in partitions {
+            if count(group) {
+                let groups[] = group;
+            }
+        }
+
+        return groups;
+    }
+
+    /**
+     * Runs the workers and collects their reports, and their metadata when
+     * a snapshot is to be written. Otherwise the metadata of the workers is
+     * saved to the cache driver once, from this process.
+     *
+     * @param bool collect
+     * @return array The reports and the ClassMetadata instances
+     */
+    protected function run(boolean collect)
+    {
+        var classNames, partitions, partition, children, file, pid, status,
+            waited, result, reports, metadata;
+
+        let classNames = this->metadataFactory->getAllClassNames();
+
+        if this->workers < 2 || !function_exists("pcntl_fork") {
+            let result = this->loadPartition(classNames, collect);
+            return [[result["report"]], result["metadata"]];
+        }
+
+        let partitions = this->getPartitions(classNames);
+        let children = [];
+        for partition in partitions {
+            let file = tempnam(this->tmpDir, "doctrine-metadata");
+            let pid = pcntl_fork();
+            if pid == -1 {
+                unlink(file);
+                this->killWorkers(children);
+                throw new \RuntimeException("Unable to fork a metadata warm-up worker");
+            }
+
+            if pid == 0 {
+                // The worker shares the cache connection of the parent, so it
+                // leaves the cache alone and hands its metadata back instead.
+                // A mapping error ends it before anything is written.
+                try {
+                    this->metadataFactory->setCacheDriver(null);
+                    file_put_contents(file, serialize(this->loadPartition(partition, true)));
+                    exit(0);
+                } catch \Exception, e {
+                    file_put_contents("php://stderr", e->getMessage() . PHP_EOL);
+                    exit(1);
+                }
+            }
+
+            let children[pid] = file;
+        }
+
+        let reports = [];
+        let metadata = [];
+        while count(children) {
+            let waited = this->waitWorker(-1);
+            let pid = waited[0];
+            let status = waited[1];
+            if !isset children[pid] {
+                continue;
+            }
+
+            let file = children[pid];
+            unset(children[pid]);
+
+            // A worker that crashed or exited with an error fails the run,
+            // whatever it managed to write
+            if !pcntl_wifexited(status) || pcntl_wexitstatus(status) != 0 {
+                let result = null;
+            } else {
+                let result = unserialize(file_get_contents(file));
+            }
+            unlink(file);
+
+            if typeof result != "array" {
+                this->killWorkers(children);
+                throw new \RuntimeException("Metadata warm-up worker " . pid . " failed, see its output for the mapping error");
+            }
+
+            let reports[] = result["report"];
+            let metadata = array_merge(metadata, result["metadata"]);
+        }
+
+        if !collect {
+            this->metadataFactory->saveMetadata(metadata);
+            return [reports, []];
+        }
+
+        return [reports, metadata];
+    }
+
+    /**
+     * Loads the metadata of a partition in the current process.
+     *
+     * @param array classNames
+     * @param bool collect
+     * @return array
+     */
+    protected function loadPartition(array classNames, boolean collect)
+    {
+        var start, className, metadata, class1;
+
+        let start = microtime(true);
+        let metadata = [];
+        for className in classNames {
+            let class1 = this->metadataFactory->getMetadataFor(className);
+            if collect {
+                let metadata[] = class1;
+            }
+        }
+
+        return [
+            "report": [
+                "pid": getmypid(),
+                "classes": count(classNames),
+                "seconds": microtime(true) - start
+            ],
+            "metadata": metadata
+        ];
+    }
+
+    /**
+     * Waits for a worker, or for any of them with -1, and retries when a
+     * signal interrupts the wait.
+     *
+     * @param int pid
+     * @return array The pid of the worker and its status
+     */
+    protected function waitWorker(int pid)
+    {
+        var status, waited;
+
+        loop {
+            let status = 0;
+            let waited = pcntl_waitpid(pid, status);
+            if waited > 0 {
+                return [waited, status];
+            }
+            if pcntl_get_last_error() != 4 { // EINTR
+                throw new \RuntimeException("Unable to wait for the metadata warm-up workers: " . pcntl_strerror(pcntl_get_last_error()));
+            }
+        }
+    }
+
+    /**
+     * Stops the workers still running after one of them failed.
+     *
+     * @param array children Result files indexed by worker pid
+     */
+    protected function killWorkers(array children)
+    {
+        var pid, file, status;
+
+        for pid, file in children {
+            posix_kill(pid, 15);
+            loop {
+                let status = 0;
+                if pcntl_waitpid(pid, status) != -1 || pcntl_get_last_error() != 4 { // EINTR
+                    break;
+                }
+            }
+            unlink(file);
+        }
+    }
+}
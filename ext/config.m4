@@ -1,14 +1,22 @@
+dnl Generated by Zephir, maintained by hand since: it also builds the native
+dnl modules, which Zephir has no hook for. See README.md before regenerating it.
+
 PHP_ARG_ENABLE(doctrine, whether to enable doctrine, [ --enable-doctrine   Enable Doctrine])
+PHP_ARG_ENABLE(doctrine-metadata-stats, whether to enable doctrine metadata statistics, [ --enable-doctrine-metadata-stats   Count metadata factory loads and timings], no, no)
 
 if test "$PHP_DOCTRINE" = "yes"; then
 	AC_DEFINE(HAVE_DOCTRINE, 1, [Whether you have Doctrine])
-	doctrine_sources="doctrine.c kernel/main.c kernel/memory.c kernel/exception.c kernel/hash.c kernel/debug.c kernel/backtrace.c kernel/object.c kernel/array.c kernel/extended/array.c kernel/string.c kernel/fcall.c kernel/require.c kernel/file.c kernel/operators.c kernel/concat.c kernel/variables.c kernel/filter.c kernel/iterator.c kernel/exit.c doctrine/mongodb/cursor.zep.c
+	if test "$PHP_DOCTRINE_METADATA_STATS" = "yes"; then
+		AC_DEFINE(DOCTRINE_METADATA_STATS, 1, [Whether to count metadata factory loads and timings])
+	fi
+	doctrine_sources="doctrine.c kernel/main.c kernel/memory.c kernel/exception.c kernel/hash.c kernel/debug.c kernel/backtrace.c kernel/object.c kernel/array.c kernel/extended/array.c kernel/string.c kernel/fcall.c kernel/require.c kernel/file.c kernel/operators.c kernel/concat.c kernel/variables.c kernel/filter.c kernel/iterator.c kernel/exit.c doctrine/common/persistence/mapping/metadatastore.c doctrine/common/persistence/mapping/metadatasnapshot.c doctrine/common/persistence/mapping/metadatastats.c doctrine/common/reflection/propertyhandle.c doctrine/common/util/realclass.c doctrine/mongodb/cursor.zep.c
 	doctrine/mongodb/iterator.zep.c
 	doctrine/odm/mongodb/cursor.zep.c
 	doctrine/odm/mongodb/documentmanager.zep.c
 	doctrine/odm/mongodb/events.zep.c
 	doctrine/odm/mongodb/hydrator/hydratorfactory.zep.c
 	doctrine/odm/mongodb/lockmode.zep.c
+	doctrine/odm/mongodb/mapping/fieldmappingtable.c
 	doctrine/odm/mongodb/persisters/collectionpersister.zep.c "
 	PHP_NEW_EXTENSION(doctrine, $doctrine_sources, $ext_shared)
 
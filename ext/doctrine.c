@@ -1,5 +1,9 @@
 
-/* This file was generated automatically by Zephir do not modify it! */
+/*
+ * Generated by Zephir, maintained by hand since: it also wires in the native
+ * modules, which Zephir has no hook for. See ext/README.md before
+ * regenerating it.
+ */
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -24,6 +28,12 @@
 #include "kernel/fcall.h"
 #include "kernel/memory.h"
 
+#include "doctrine/common/persistence/mapping/metadatastore.h"
+#include "doctrine/common/persistence/mapping/metadatasnapshot.h"
+#include "doctrine/common/persistence/mapping/metadatastats.h"
+#include "doctrine/common/util/realclass.h"
+
+zend_class_entry *doctrine_common_reflection_propertyhandle_ce;
 zend_class_entry *doctrine_mongodb_iterator_ce;
 zend_class_entry *doctrine_mongodb_cursor_ce;
 zend_class_entry *doctrine_odm_mongodb_cursor_ce;
@@ -31,12 +41,82 @@ zend_class_entry *doctrine_odm_mongodb_documentmanager_ce;
 zend_class_entry *doctrine_odm_mongodb_events_ce;
 zend_class_entry *doctrine_odm_mongodb_hydrator_hydratorfactory_ce;
 zend_class_entry *doctrine_odm_mongodb_lockmode_ce;
+zend_class_entry *doctrine_odm_mongodb_mapping_fieldmappingtable_ce;
 zend_class_entry *doctrine_odm_mongodb_persisters_collectionpersister_ce;
 
 ZEND_DECLARE_MODULE_GLOBALS(doctrine)
 
 #define ZEPHIR_NUM_PREALLOCATED_FRAMES 25
+#define ZEPHIR_FRAME_CAPACITY 24
+#define ZEPHIR_FRAME_HASH_CAPACITY 8
+#define ZEPHIR_MAX_FRAME_CAPACITY 512
+#define ZEPHIR_MAX_FRAME_HASH_CAPACITY 128
+
+PHP_INI_BEGIN()
+	/* Size in bytes of the process-wide metadata store, 0 disables it */
+	PHP_INI_ENTRY("doctrine.metadata_store_size", "0", PHP_INI_SYSTEM, NULL)
+	/* Prefix of the store keys, applications sharing a master need their own */
+	PHP_INI_ENTRY("doctrine.metadata_store_namespace", "", PHP_INI_ALL, NULL)
+	/* Minimum number and capacities of the preallocated memory frames, the
+	 * pool grows past them to the high-water marks of doctrine_memory_stats() */
+	PHP_INI_ENTRY("doctrine.memory_frames", "25", PHP_INI_SYSTEM, NULL)
+	PHP_INI_ENTRY("doctrine.memory_frame_capacity", "24", PHP_INI_SYSTEM, NULL)
+	PHP_INI_ENTRY("doctrine.memory_frame_hash_capacity", "8", PHP_INI_SYSTEM, NULL)
+	/* Memoize ClassUtils::getRealClass() per process */
+	PHP_INI_ENTRY("doctrine.real_class_cache", "1", PHP_INI_SYSTEM, NULL)
+PHP_INI_END()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_memory_stats, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/*
+ * The global constants are allocated like the zvals of the engine, the GC
+ * macros may look at the buffer pointer that follows the zval. Their
+ * refcount is pinned so high that the decrements of a request can never
+ * bring it to 0 and have the engine free them
+ */
+#if PHP_VERSION_ID >= 50300
+# define ZEPHIR_GLOBAL_CONSTANT_SIZE sizeof(zval_gc_info)
+#else
+# define ZEPHIR_GLOBAL_CONSTANT_SIZE sizeof(zval)
+#endif
+#define ZEPHIR_GLOBAL_CONSTANT_REFCOUNT 0x40000000
 
+static zval *zephir_alloc_global_constant(void)
+{
+	zval *constant = pemalloc(ZEPHIR_GLOBAL_CONSTANT_SIZE, 1);
+
+#if PHP_VERSION_ID >= 50300
+	GC_ZVAL_INIT(constant);
+#endif
+	return constant;
+}
+
+/**
+ * Restores the global constants, an unbalanced refcount left by a request
+ * must not reach the next one
+ */
+static void zephir_reset_global_constants(zend_zephir_globals_def *zephir_globals_ptr)
+{
+	INIT_PZVAL(zephir_globals_ptr->global_null);
+	ZVAL_NULL(zephir_globals_ptr->global_null);
+	Z_SET_REFCOUNT_P(zephir_globals_ptr->global_null, ZEPHIR_GLOBAL_CONSTANT_REFCOUNT);
+
+	INIT_PZVAL(zephir_globals_ptr->global_false);
+	ZVAL_FALSE(zephir_globals_ptr->global_false);
+	Z_SET_REFCOUNT_P(zephir_globals_ptr->global_false, ZEPHIR_GLOBAL_CONSTANT_REFCOUNT);
+
+	INIT_PZVAL(zephir_globals_ptr->global_true);
+	ZVAL_TRUE(zephir_globals_ptr->global_true);
+	Z_SET_REFCOUNT_P(zephir_globals_ptr->global_true, ZEPHIR_GLOBAL_CONSTANT_REFCOUNT);
+}
+
+/*
+ * The frame pool, the function cache and the global constants live as long
+ * as the process (or the thread in ZTS builds): they are allocated from
+ * GINIT and released from GSHUTDOWN. Requests only reset them, so the
+ * capacity each frame grew to is kept for the next request.
+ */
 void zephir_initialize_memory(zend_zephir_globals_def *zephir_globals_ptr TSRMLS_DC)
 {
 	zephir_memory_entry *start;
@@ -50,10 +130,10 @@ void zephir_initialize_memory(zend_zephir_globals_def *zephir_globals_ptr TSRMLS
 	start->next = NULL;
 */
 	for (i = 0; i < ZEPHIR_NUM_PREALLOCATED_FRAMES; ++i) {
-		start[i].addresses       = pecalloc(24, sizeof(zval*), 1);
-		start[i].capacity        = 24;
-		start[i].hash_addresses  = pecalloc(8, sizeof(zval*), 1);
-		start[i].hash_capacity   = 8;
+		start[i].addresses       = pecalloc(ZEPHIR_FRAME_CAPACITY, sizeof(zval*), 1);
+		start[i].capacity        = ZEPHIR_FRAME_CAPACITY;
+		start[i].hash_addresses  = pecalloc(ZEPHIR_FRAME_HASH_CAPACITY, sizeof(zval*), 1);
+		start[i].hash_capacity   = ZEPHIR_FRAME_HASH_CAPACITY;
 
 #ifndef ZEPHIR_RELEASE
 		start[i].permanent = 1;
@@ -71,24 +151,156 @@ void zephir_initialize_memory(zend_zephir_globals_def *zephir_globals_ptr TSRMLS
 	zephir_globals_ptr->start_memory = start;
 	zephir_globals_ptr->end_memory   = start + ZEPHIR_NUM_PREALLOCATED_FRAMES;
 
+	zephir_globals_ptr->memory_depth               = 0;
+	zephir_globals_ptr->memory_depth_peak          = 0;
+	zephir_globals_ptr->memory_capacity_peak       = ZEPHIR_FRAME_CAPACITY;
+	zephir_globals_ptr->memory_hash_capacity_peak  = ZEPHIR_FRAME_HASH_CAPACITY;
+	zephir_globals_ptr->memory_overflow_frames     = 0;
+	zephir_globals_ptr->memory_reallocations       = 0;
+	zephir_globals_ptr->zval_free_count            = 0;
+	zephir_globals_ptr->symbol_table_pool_count    = 0;
+
+	for (i = 0; i < ZEPHIR_MAX_PREALLOCATED_FRAMES; ++i) {
+		zephir_globals_ptr->memory_capacity_peaks[i]      = ZEPHIR_FRAME_CAPACITY;
+		zephir_globals_ptr->memory_hash_capacity_peaks[i] = ZEPHIR_FRAME_HASH_CAPACITY;
+	}
+
 	zephir_globals_ptr->fcache = pemalloc(sizeof(HashTable), 1);
 	zend_hash_init(zephir_globals_ptr->fcache, 128, NULL, NULL, 1); // zephir_fcall_cache_dtor
 
-	/* 'Allocator sizeof operand mismatch' warning can be safely ignored */
-	ALLOC_INIT_ZVAL(zephir_globals_ptr->global_null);
-	Z_SET_REFCOUNT_P(zephir_globals_ptr->global_null, 2);
+	/* Persistent, the request allocator is reset between requests */
+	zephir_globals_ptr->global_null  = zephir_alloc_global_constant();
+	zephir_globals_ptr->global_false = zephir_alloc_global_constant();
+	zephir_globals_ptr->global_true  = zephir_alloc_global_constant();
+	zephir_reset_global_constants(zephir_globals_ptr);
 
-	/* 'Allocator sizeof operand mismatch' warning can be safely ignored */
-	ALLOC_INIT_ZVAL(zephir_globals_ptr->global_false);
-	Z_SET_REFCOUNT_P(zephir_globals_ptr->global_false, 2);
-	ZVAL_FALSE(zephir_globals_ptr->global_false);
+	//zephir_globals_ptr->initialized = 1;
+}
 
-	/* 'Allocator sizeof operand mismatch' warning can be safely ignored */
-	ALLOC_INIT_ZVAL(zephir_globals_ptr->global_true);
-	Z_SET_REFCOUNT_P(zephir_globals_ptr->global_true, 2);
-	ZVAL_TRUE(zephir_globals_ptr->global_true);
+/**
+ * Grows the frame pool to the deepest stack seen, and each preallocated
+ * frame to the largest capacities seen at its depth, or to the php.ini
+ * minimums. Every limit is capped, a single method observing many variables
+ * must not grow its frame past them. Called from RINIT, while no frame is
+ * active, so the pool can move. It never shrinks
+ */
+static void zephir_resize_memory(zend_zephir_globals_def *zephir_globals_ptr TSRMLS_DC)
+{
+	zephir_memory_entry *start;
+	size_t i, current, frames, capacity, hash_capacity, min_capacity, min_hash_capacity;
+	long ini;
 
-	//zephir_globals_ptr->initialized = 1;
+	current = zephir_globals_ptr->end_memory - zephir_globals_ptr->start_memory;
+
+	frames = zephir_globals_ptr->memory_depth_peak;
+	ini = INI_INT("doctrine.memory_frames");
+	if (ini > 0 && (size_t) ini > frames) {
+		frames = (size_t) ini;
+	}
+	if (frames > ZEPHIR_MAX_PREALLOCATED_FRAMES) {
+		frames = ZEPHIR_MAX_PREALLOCATED_FRAMES;
+	}
+
+	ini = INI_INT("doctrine.memory_frame_capacity");
+	min_capacity = ini > 0 ? (size_t) ini : 0;
+	ini = INI_INT("doctrine.memory_frame_hash_capacity");
+	min_hash_capacity = ini > 0 ? (size_t) ini : 0;
+
+	if (frames > current) {
+		start = perealloc(zephir_globals_ptr->start_memory, frames * sizeof(zephir_memory_entry), 1);
+		memset(start + current, 0, (frames - current) * sizeof(zephir_memory_entry));
+
+		for (i = 0; i < frames; ++i) {
+			start[i].prev = i ? &start[i - 1] : NULL;
+			start[i].next = i + 1 < frames ? &start[i + 1] : NULL;
+#ifndef ZEPHIR_RELEASE
+			start[i].permanent = 1;
+#endif
+		}
+
+		zephir_globals_ptr->start_memory = start;
+		zephir_globals_ptr->end_memory   = start + frames;
+	} else {
+		start  = zephir_globals_ptr->start_memory;
+		frames = current;
+	}
+
+	for (i = 0; i < frames; ++i) {
+		capacity = zephir_globals_ptr->memory_capacity_peaks[i];
+		if (capacity < min_capacity) {
+			capacity = min_capacity;
+		}
+		if (capacity > ZEPHIR_MAX_FRAME_CAPACITY) {
+			capacity = ZEPHIR_MAX_FRAME_CAPACITY;
+		}
+		if (start[i].capacity < capacity) {
+			start[i].addresses = perealloc(start[i].addresses, capacity * sizeof(zval*), 1);
+			start[i].capacity  = capacity;
+		}
+
+		hash_capacity = zephir_globals_ptr->memory_hash_capacity_peaks[i];
+		if (hash_capacity < min_hash_capacity) {
+			hash_capacity = min_hash_capacity;
+		}
+		if (hash_capacity > ZEPHIR_MAX_FRAME_HASH_CAPACITY) {
+			hash_capacity = ZEPHIR_MAX_FRAME_HASH_CAPACITY;
+		}
+		if (start[i].hash_capacity < hash_capacity) {
+			start[i].hash_addresses = perealloc(start[i].hash_addresses, hash_capacity * sizeof(zval*), 1);
+			start[i].hash_capacity  = hash_capacity;
+		}
+	}
+}
+
+/**
+ * Returns the size of the frame pool and the high-water marks it is sized
+ * from, which can be pinned with the doctrine.memory_* php.ini settings
+ */
+PHP_FUNCTION(doctrine_memory_stats)
+{
+	zend_zephir_globals_def *zephir_globals_ptr = ZEPHIR_VGLOBAL;
+	zephir_memory_entry *frame;
+	size_t i, depth, frame_capacity = 0, frame_hash_capacity = 0;
+	zval *capacity_peaks, *hash_capacity_peaks;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	for (frame = zephir_globals_ptr->start_memory; frame < zephir_globals_ptr->end_memory; ++frame) {
+		if (frame->capacity > frame_capacity) {
+			frame_capacity = frame->capacity;
+		}
+		if (frame->hash_capacity > frame_hash_capacity) {
+			frame_hash_capacity = frame->hash_capacity;
+		}
+	}
+
+	depth = zephir_globals_ptr->memory_depth_peak;
+	if (depth > ZEPHIR_MAX_PREALLOCATED_FRAMES) {
+		depth = ZEPHIR_MAX_PREALLOCATED_FRAMES;
+	}
+
+	MAKE_STD_ZVAL(capacity_peaks);
+	array_init_size(capacity_peaks, depth);
+	MAKE_STD_ZVAL(hash_capacity_peaks);
+	array_init_size(hash_capacity_peaks, depth);
+	for (i = 0; i < depth; ++i) {
+		add_next_index_long(capacity_peaks, (long) zephir_globals_ptr->memory_capacity_peaks[i]);
+		add_next_index_long(hash_capacity_peaks, (long) zephir_globals_ptr->memory_hash_capacity_peaks[i]);
+	}
+
+	array_init_size(return_value, 10);
+	add_assoc_long(return_value, "frames", (long) (zephir_globals_ptr->end_memory - zephir_globals_ptr->start_memory));
+	add_assoc_long(return_value, "frame_capacity", (long) frame_capacity);
+	add_assoc_long(return_value, "frame_hash_capacity", (long) frame_hash_capacity);
+	add_assoc_long(return_value, "depth_peak", (long) zephir_globals_ptr->memory_depth_peak);
+	add_assoc_long(return_value, "capacity_peak", (long) zephir_globals_ptr->memory_capacity_peak);
+	add_assoc_long(return_value, "hash_capacity_peak", (long) zephir_globals_ptr->memory_hash_capacity_peak);
+	add_assoc_zval(return_value, "capacity_peaks", capacity_peaks);
+	add_assoc_zval(return_value, "hash_capacity_peaks", hash_capacity_peaks);
+	add_assoc_long(return_value, "overflow_frames", (long) zephir_globals_ptr->memory_overflow_frames);
+	add_assoc_long(return_value, "reallocations", (long) zephir_globals_ptr->memory_reallocations);
 }
 
 int zephir_cleanup_fcache(void *pDest TSRMLS_DC, int num_args, va_list args, zend_hash_key *hash_key)
@@ -136,29 +348,53 @@ int zephir_cleanup_fcache(void *pDest TSRMLS_DC, int num_args, va_list args, zen
 	return ZEND_HASH_APPLY_KEEP;
 }
 
-void zephir_deinitialize_memory(TSRMLS_D)
+/**
+ * Ends the request: unwinds the frames still active, drops the function
+ * cache entries of userland code and resets the global constants. The
+ * frames themselves are kept
+ */
+void zephir_reset_memory(TSRMLS_D)
 {
-	size_t i;
 	zend_zephir_globals_def *zephir_globals_ptr = ZEPHIR_VGLOBAL;
 
+	if (zephir_globals_ptr->start_memory == NULL) {
+		return;
+	}
+
+	zephir_clean_restore_stack(TSRMLS_C);
+
+	zephir_zval_free_list_drain(TSRMLS_C);
+	zephir_symbol_table_pool_drain(TSRMLS_C);
+
+	zend_hash_apply_with_arguments(zephir_globals_ptr->fcache TSRMLS_CC, zephir_cleanup_fcache, 0);
+
+	zephir_reset_global_constants(zephir_globals_ptr);
+
+	zephir_globals_ptr->memory_depth = 0;
+	zephir_globals_ptr->active_memory = NULL;
+	zephir_globals_ptr->active_symbol_table = NULL;
+}
+
+/**
+ * Releases the frame pool, the function cache and the global constants,
+ * called from GSHUTDOWN
+ */
+void zephir_deinitialize_memory(zend_zephir_globals_def *zephir_globals_ptr TSRMLS_DC)
+{
+	size_t i;
+
 	//if (zephir_globals_ptr->initialized != 1) {
 	//	zephir_globals_ptr->initialized = 0;
 	//	return;
 	//}
 
-	if (zephir_globals_ptr->start_memory != NULL) {
-		zephir_clean_restore_stack(TSRMLS_C);
+	if (zephir_globals_ptr->start_memory == NULL) {
+		return;
 	}
 
 	//zephir_orm_destroy_cache(TSRMLS_C);
 
-	zend_hash_apply_with_arguments(zephir_globals_ptr->fcache TSRMLS_CC, zephir_cleanup_fcache, 0);
-
-#ifndef ZEPHIR_RELEASE
-	assert(zephir_globals_ptr->start_memory != NULL);
-#endif
-
-	for (i = 0; i < ZEPHIR_NUM_PREALLOCATED_FRAMES; ++i) {
+	for (i = 0; i < (size_t) (zephir_globals_ptr->end_memory - zephir_globals_ptr->start_memory); ++i) {
 		pefree(zephir_globals_ptr->start_memory[i].hash_addresses, 1);
 		pefree(zephir_globals_ptr->start_memory[i].addresses, 1);
 	}
@@ -170,11 +406,9 @@ void zephir_deinitialize_memory(TSRMLS_D)
 	pefree(zephir_globals_ptr->fcache, 1);
 	zephir_globals_ptr->fcache = NULL;
 
-	for (i = 0; i < 2; i++) {
-		zval_ptr_dtor(&zephir_globals_ptr->global_null);
-		zval_ptr_dtor(&zephir_globals_ptr->global_false);
-		zval_ptr_dtor(&zephir_globals_ptr->global_true);
-	}
+	pefree(zephir_globals_ptr->global_null, 1);
+	pefree(zephir_globals_ptr->global_false, 1);
+	pefree(zephir_globals_ptr->global_true, 1);
 
 	//zephir_globals_ptr->initialized = 0;
 }
@@ -197,6 +431,17 @@ static PHP_MINIT_FUNCTION(doctrine)
 	setlocale(LC_ALL, "C");
 #endif
 
+	REGISTER_INI_ENTRIES();
+
+	if (INI_INT("doctrine.metadata_store_size") > 0) {
+		if (doctrine_metadata_store_init((size_t) INI_INT("doctrine.metadata_store_size")) == FAILURE) {
+			zend_error(E_WARNING, "Unable to allocate the doctrine metadata store");
+		}
+	}
+
+	doctrine_metadata_snapshot_startup();
+
+	ZEPHIR_INIT(Doctrine_Common_Reflection_PropertyHandle);
 	ZEPHIR_INIT(Doctrine_MongoDB_Iterator);
 	ZEPHIR_INIT(Doctrine_MongoDB_Cursor);
 	ZEPHIR_INIT(Doctrine_ODM_MongoDB_Cursor);
@@ -204,6 +449,7 @@ static PHP_MINIT_FUNCTION(doctrine)
 	ZEPHIR_INIT(Doctrine_ODM_MongoDB_Events);
 	ZEPHIR_INIT(Doctrine_ODM_MongoDB_Hydrator_HydratorFactory);
 	ZEPHIR_INIT(Doctrine_ODM_MongoDB_LockMode);
+	ZEPHIR_INIT(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable);
 	ZEPHIR_INIT(Doctrine_ODM_MongoDB_Persisters_CollectionPersister);
 
 #if PHP_VERSION_ID < 50500
@@ -213,18 +459,19 @@ static PHP_MINIT_FUNCTION(doctrine)
 	return SUCCESS;
 }
 
-#ifndef ZEPHIR_RELEASE
 static PHP_MSHUTDOWN_FUNCTION(doctrine)
 {
 
-	zephir_deinitialize_memory(TSRMLS_C);
-
 	//assert(ZEPHIR_GLOBAL(orm).parser_cache == NULL);
 	//assert(ZEPHIR_GLOBAL(orm).ast_cache == NULL);
 
+	doctrine_metadata_store_shutdown();
+	doctrine_metadata_snapshot_shutdown();
+
+	UNREGISTER_INI_ENTRIES();
+
 	return SUCCESS;
 }
-#endif
 
 /**
  * Initialize globals on each request or each thread started
@@ -252,7 +499,8 @@ static PHP_RINIT_FUNCTION(doctrine)
 	php_zephir_init_globals(zephir_globals_ptr TSRMLS_CC);
 	//zephir_init_interned_strings(TSRMLS_C);
 
-	zephir_initialize_memory(zephir_globals_ptr TSRMLS_CC);
+	zephir_resize_memory(zephir_globals_ptr TSRMLS_CC);
+	doctrine_real_class_cache_rinit(TSRMLS_C);
 
 	return SUCCESS;
 }
@@ -260,7 +508,9 @@ static PHP_RINIT_FUNCTION(doctrine)
 static PHP_RSHUTDOWN_FUNCTION(doctrine)
 {
 
-	zephir_deinitialize_memory(TSRMLS_C);
+	doctrine_property_handle_release(TSRMLS_C);
+	doctrine_metadata_store_release_claims(TSRMLS_C);
+	zephir_reset_memory(TSRMLS_C);
 	return SUCCESS;
 }
 
@@ -277,31 +527,77 @@ static PHP_MINFO_FUNCTION(doctrine)
 	php_info_print_table_row(2, "Powered by Zephir", "Version " PHP_DOCTRINE_ZEPVERSION);
 	php_info_print_table_end();
 
+	{
+		size_t size, used;
+		unsigned long entries, refused;
+		char buf[64];
+
+		doctrine_metadata_store_info(&size, &used, &entries, &refused);
+
+		php_info_print_table_start();
+		php_info_print_table_header(2, "Metadata store", doctrine_metadata_store_enabled() ? "enabled" : "disabled");
+		snprintf(buf, sizeof(buf), "%lu / %lu bytes", (unsigned long) used, (unsigned long) size);
+		php_info_print_table_row(2, "Used", buf);
+		snprintf(buf, sizeof(buf), "%lu", entries);
+		php_info_print_table_row(2, "Entries", buf);
+		snprintf(buf, sizeof(buf), "%lu", refused);
+		php_info_print_table_row(2, "Refused (store full)", buf);
+		php_info_print_table_end();
+	}
+
+	doctrine_metadata_stats_minfo(TSRMLS_C);
+
+	DISPLAY_INI_ENTRIES();
+
 
 }
 
 static PHP_GINIT_FUNCTION(doctrine)
 {
 	php_zephir_init_globals(doctrine_globals TSRMLS_CC);
+	zephir_initialize_memory(doctrine_globals TSRMLS_CC);
+	doctrine_real_class_cache_init(doctrine_globals);
+	doctrine_property_handle_init(doctrine_globals);
+
+#ifdef DOCTRINE_METADATA_STATS
+	memset(doctrine_globals->metadata_stats_count, 0, sizeof(doctrine_globals->metadata_stats_count));
+	memset(doctrine_globals->metadata_stats_time, 0, sizeof(doctrine_globals->metadata_stats_time));
+#endif
 }
 
 static PHP_GSHUTDOWN_FUNCTION(doctrine)
 {
-
+	zephir_deinitialize_memory(doctrine_globals TSRMLS_CC);
+	doctrine_real_class_cache_destroy(doctrine_globals);
 }
 
+static const zend_function_entry doctrine_functions[] = {
+	PHP_FE(doctrine_metadata_store_claim, arginfo_doctrine_metadata_store_claim)
+	PHP_FE(doctrine_metadata_store_fetch, arginfo_doctrine_metadata_store_fetch)
+	PHP_FE(doctrine_metadata_store_save, arginfo_doctrine_metadata_store_save)
+	PHP_FE(doctrine_metadata_store_reset, arginfo_doctrine_metadata_store_reset)
+	PHP_FE(doctrine_metadata_snapshot_write, arginfo_doctrine_metadata_snapshot_write)
+	PHP_FE(doctrine_metadata_snapshot_open, arginfo_doctrine_metadata_snapshot_open)
+	PHP_FE(doctrine_metadata_snapshot_fetch, arginfo_doctrine_metadata_snapshot_fetch)
+	PHP_FE(doctrine_get_real_class, arginfo_doctrine_get_real_class)
+	PHP_FE(doctrine_real_class_cache_info, arginfo_doctrine_real_class_cache_info)
+	PHP_FE(doctrine_metadata_stats_enabled, arginfo_doctrine_metadata_stats_none)
+	PHP_FE(doctrine_metadata_stats_clock, arginfo_doctrine_metadata_stats_none)
+	PHP_FE(doctrine_metadata_stats_record, arginfo_doctrine_metadata_stats_record)
+	PHP_FE(doctrine_metadata_stats, arginfo_doctrine_metadata_stats_none)
+	PHP_FE(doctrine_metadata_stats_reset, arginfo_doctrine_metadata_stats_none)
+	PHP_FE(doctrine_memory_stats, arginfo_doctrine_memory_stats)
+	PHP_FE_END
+};
+
 zend_module_entry doctrine_module_entry = {
 	STANDARD_MODULE_HEADER_EX,
 	NULL,
 	NULL,
 	PHP_DOCTRINE_EXTNAME,
-	NULL,
+	doctrine_functions,
 	PHP_MINIT(doctrine),
-#ifndef ZEPHIR_RELEASE
 	PHP_MSHUTDOWN(doctrine),
-#else
-	NULL,
-#endif
 	PHP_RINIT(doctrine),
 	PHP_RSHUTDOWN(doctrine),
 	PHP_MINFO(doctrine),
@@ -1,9 +1,14 @@
 
-/* This file was generated automatically by Zephir do not modify it! */
+/*
+ * Generated by Zephir, maintained by hand since: it also wires in the native
+ * modules, which Zephir has no hook for. See ext/README.md before
+ * regenerating it.
+ */
 
 #ifndef ZEPHIR_CLASS_ENTRIES_H
 #define ZEPHIR_CLASS_ENTRIES_H
 
+#include "doctrine/common/reflection/propertyhandle.h"
 #include "doctrine/mongodb/cursor.zep.h"
 #include "doctrine/mongodb/iterator.zep.h"
 #include "doctrine/odm/mongodb/cursor.zep.h"
@@ -11,6 +16,7 @@
 #include "doctrine/odm/mongodb/events.zep.h"
 #include "doctrine/odm/mongodb/hydrator/hydratorfactory.zep.h"
 #include "doctrine/odm/mongodb/lockmode.zep.h"
+#include "doctrine/odm/mongodb/mapping/fieldmappingtable.h"
 #include "doctrine/odm/mongodb/persisters/collectionpersister.zep.h"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,431 @@
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+
+#include "ext/standard/crc32.h"
+#include "ext/standard/php_var.h"
+
+#include "kernel/main.h"
+#include "kernel/variables.h"
+
+#include "doctrine/common/persistence/mapping/metadatasnapshot.h"
+
+#ifndef PHP_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/*
+ * Metadata snapshots
+ *-------------------
+ *
+ * A snapshot is a binary image of every ClassMetadata known to a factory,
+ * written once at deploy time and mapped read-only at runtime:
+ *
+ *   header | version | buckets | entries
+ *
+ * The header carries a format number, the size of the image and a crc32 of
+ * everything that follows it; the version string is chosen by the deploy
+ * step. An image whose format, version, size or checksum does not match is
+ * refused and the factory keeps using its usual loading path.
+ *
+ * Mapped images stay mapped for the lifetime of the process. A new deploy
+ * is expected to come with a new version (or path), which maps a new image
+ * next to the old one instead of replacing it under running requests.
+ *
+ * Entries are still serialized: objects cannot outlive the request that
+ * created them, so each fetch unserializes its entry, once per class and
+ * factory. What a snapshot saves is the cache driver round trip and the
+ * mapping driver (initialize() is not needed for classes found in it), not
+ * the unserialize() cost.
+ */
+
+#define DOCTRINE_METADATA_SNAPSHOT_MAGIC "DOCMETA"
+#define DOCTRINE_METADATA_SNAPSHOT_FORMAT 1
+#define DOCTRINE_METADATA_SNAPSHOT_MAX 8
+
+#define DOCTRINE_METADATA_SNAPSHOT_ALIGN(size) (((size) + 7) & ~((size_t) 7))
+
+typedef struct _doctrine_metadata_snapshot_header {
+	char magic[8];
+	uint32_t format;
+	uint32_t checksum;
+	uint32_t size;
+	uint32_t entries;
+	uint32_t buckets;
+	uint32_t version_len;
+} doctrine_metadata_snapshot_header;
+
+typedef struct _doctrine_metadata_snapshot_entry {
+	uint32_t next;
+	uint32_t hash;
+	uint32_t key_len;
+	uint32_t value_len;
+	char data[1];
+} doctrine_metadata_snapshot_entry;
+
+typedef struct _doctrine_metadata_snapshot {
+	char *path;
+	const char *image;
+	size_t size;
+} doctrine_metadata_snapshot;
+
+static doctrine_metadata_snapshot doctrine_metadata_snapshots[DOCTRINE_METADATA_SNAPSHOT_MAX];
+static volatile int doctrine_metadata_snapshots_count = 0;
+
+#ifdef ZTS
+static MUTEX_T doctrine_metadata_snapshot_mutex = NULL;
+#endif
+
+#define DOCTRINE_METADATA_SNAPSHOT_BUCKETS_OFFSET(header) \
+	(DOCTRINE_METADATA_SNAPSHOT_ALIGN(sizeof(doctrine_metadata_snapshot_header)) + DOCTRINE_METADATA_SNAPSHOT_ALIGN((header)->version_len))
+
+#define DOCTRINE_METADATA_SNAPSHOT_ENTRIES_OFFSET(header) \
+	(DOCTRINE_METADATA_SNAPSHOT_BUCKETS_OFFSET(header) + DOCTRINE_METADATA_SNAPSHOT_ALIGN((size_t) (header)->buckets * sizeof(uint32_t)))
+
+void doctrine_metadata_snapshot_startup(void)
+{
+#ifdef ZTS
+	doctrine_metadata_snapshot_mutex = tsrm_mutex_alloc();
+#endif
+}
+
+void doctrine_metadata_snapshot_shutdown(void)
+{
+	int i;
+
+	for (i = 0; i < doctrine_metadata_snapshots_count; i++) {
+#ifndef PHP_WIN32
+		munmap((void *) doctrine_metadata_snapshots[i].image, doctrine_metadata_snapshots[i].size);
+#endif
+		free(doctrine_metadata_snapshots[i].path);
+	}
+	doctrine_metadata_snapshots_count = 0;
+
+#ifdef ZTS
+	tsrm_mutex_free(doctrine_metadata_snapshot_mutex);
+	doctrine_metadata_snapshot_mutex = NULL;
+#endif
+}
+
+static uint32_t doctrine_metadata_snapshot_checksum(const char *data, size_t length)
+{
+	uint32_t crc = 0xFFFFFFFF;
+
+	while (length--) {
+		CRC32(crc, *data++);
+	}
+
+	return ~crc;
+}
+
+/**
+ * Checks that an image was written by this format, for this version, and
+ * has not been truncated or modified since
+ */
+static int doctrine_metadata_snapshot_valid(const char *image, size_t size, const char *version, uint version_len)
+{
+	const doctrine_metadata_snapshot_header *header = (const doctrine_metadata_snapshot_header *) image;
+
+	if (size < sizeof(doctrine_metadata_snapshot_header)) {
+		return 0;
+	}
+
+	if (memcmp(header->magic, DOCTRINE_METADATA_SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+		return 0;
+	}
+
+	if (header->format != DOCTRINE_METADATA_SNAPSHOT_FORMAT || header->size != size) {
+		return 0;
+	}
+
+	if (header->buckets == 0 || (header->buckets & (header->buckets - 1)) != 0) {
+		return 0;
+	}
+
+	if (DOCTRINE_METADATA_SNAPSHOT_ENTRIES_OFFSET(header) > size) {
+		return 0;
+	}
+
+	if (header->version_len != version_len || memcmp(image + sizeof(doctrine_metadata_snapshot_header), version, version_len) != 0) {
+		return 0;
+	}
+
+	return header->checksum == doctrine_metadata_snapshot_checksum(
+		image + sizeof(doctrine_metadata_snapshot_header), size - sizeof(doctrine_metadata_snapshot_header)
+	);
+}
+
+/**
+ * Writes the given ClassMetadata instances, indexed by cache key, into a
+ * snapshot image. The image is written next to its final path and renamed
+ * over it, so readers never see a partial file.
+ */
+PHP_FUNCTION(doctrine_metadata_snapshot_write)
+{
+	char *path, *version, *key, *image, *tmp_path;
+	int path_len, version_len;
+	uint key_len, i, count;
+	ulong num_key;
+	size_t size, offset;
+	zval *entries, **value, *serialized;
+	char **keys;
+	uint *key_lens;
+	uint32_t *buckets, bucket_count, slot, hash;
+	HashPosition pos;
+	doctrine_metadata_snapshot_header *header;
+	doctrine_metadata_snapshot_entry *entry;
+	php_stream *stream;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "pas", &path, &path_len, &entries, &version, &version_len) == FAILURE) {
+		return;
+	}
+
+	count = zend_hash_num_elements(Z_ARRVAL_P(entries));
+
+	serialized = (zval *) ecalloc(count + 1, sizeof(zval));
+	keys       = (char **) ecalloc(count + 1, sizeof(char *));
+	key_lens   = (uint *) ecalloc(count + 1, sizeof(uint));
+
+	header = NULL;
+	image  = NULL;
+
+	for (bucket_count = 16; bucket_count < count * 2; bucket_count <<= 1);
+
+	size = DOCTRINE_METADATA_SNAPSHOT_ALIGN(sizeof(doctrine_metadata_snapshot_header))
+		+ DOCTRINE_METADATA_SNAPSHOT_ALIGN(version_len)
+		+ DOCTRINE_METADATA_SNAPSHOT_ALIGN(bucket_count * sizeof(uint32_t));
+
+	i = 0;
+	zend_hash_internal_pointer_reset_ex(Z_ARRVAL_P(entries), &pos);
+	while (zend_hash_get_current_data_ex(Z_ARRVAL_P(entries), (void **) &value, &pos) == SUCCESS) {
+
+		if (zend_hash_get_current_key_ex(Z_ARRVAL_P(entries), &key, &key_len, &num_key, 0, &pos) != HASH_KEY_IS_STRING) {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING, "Snapshot entries must be indexed by cache key");
+			goto failure;
+		}
+
+		INIT_ZVAL(serialized[i]);
+		zephir_serialize(&serialized[i], value TSRMLS_CC);
+		if (Z_TYPE(serialized[i]) != IS_STRING) {
+			goto failure;
+		}
+
+		keys[i]     = key;
+		key_lens[i] = key_len - 1;
+		size += DOCTRINE_METADATA_SNAPSHOT_ALIGN(XtOffsetOf(doctrine_metadata_snapshot_entry, data) + key_lens[i] + Z_STRLEN(serialized[i]));
+
+		i++;
+		zend_hash_move_forward_ex(Z_ARRVAL_P(entries), &pos);
+	}
+
+	if (size > UINT32_MAX) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Snapshot image would exceed 4GB");
+		goto failure;
+	}
+
+	image = (char *) ecalloc(1, size);
+
+	header = (doctrine_metadata_snapshot_header *) image;
+	memcpy(header->magic, DOCTRINE_METADATA_SNAPSHOT_MAGIC, sizeof(header->magic));
+	header->format      = DOCTRINE_METADATA_SNAPSHOT_FORMAT;
+	header->size        = (uint32_t) size;
+	header->entries     = count;
+	header->buckets     = bucket_count;
+	header->version_len = version_len;
+	memcpy(image + sizeof(doctrine_metadata_snapshot_header), version, version_len);
+
+	buckets = (uint32_t *) (image + DOCTRINE_METADATA_SNAPSHOT_BUCKETS_OFFSET(header));
+	offset  = DOCTRINE_METADATA_SNAPSHOT_ENTRIES_OFFSET(header);
+
+	for (i = 0; i < count; i++) {
+		hash = (uint32_t) zend_inline_hash_func(keys[i], key_lens[i]);
+		slot = hash & (header->buckets - 1);
+
+		entry = (doctrine_metadata_snapshot_entry *) (image + offset);
+		entry->next      = buckets[slot];
+		entry->hash      = hash;
+		entry->key_len   = key_lens[i];
+		entry->value_len = Z_STRLEN(serialized[i]);
+		memcpy(entry->data, keys[i], key_lens[i]);
+		memcpy(entry->data + key_lens[i], Z_STRVAL(serialized[i]), Z_STRLEN(serialized[i]));
+
+		buckets[slot] = (uint32_t) offset;
+		offset += DOCTRINE_METADATA_SNAPSHOT_ALIGN(XtOffsetOf(doctrine_metadata_snapshot_entry, data) + entry->key_len + entry->value_len);
+	}
+
+	header->checksum = doctrine_metadata_snapshot_checksum(
+		image + sizeof(doctrine_metadata_snapshot_header), size - sizeof(doctrine_metadata_snapshot_header)
+	);
+
+	spprintf(&tmp_path, 0, "%s.%ld.tmp", path, (long) getpid());
+	stream = php_stream_open_wrapper(tmp_path, "wb", REPORT_ERRORS, NULL);
+	if (stream == NULL) {
+		efree(tmp_path);
+		goto failure;
+	}
+
+	if (php_stream_write(stream, image, size) != size) {
+		php_stream_close(stream);
+		VCWD_UNLINK(tmp_path);
+		efree(tmp_path);
+		goto failure;
+	}
+	php_stream_close(stream);
+
+	if (VCWD_RENAME(tmp_path, path) != 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Unable to move the snapshot image to %s", path);
+		VCWD_UNLINK(tmp_path);
+		efree(tmp_path);
+		goto failure;
+	}
+	efree(tmp_path);
+
+	RETVAL_TRUE;
+	goto cleanup;
+
+failure:
+	RETVAL_FALSE;
+
+cleanup:
+	for (i = 0; i < count; i++) {
+		zval_dtor(&serialized[i]);
+	}
+	efree(serialized);
+	efree(keys);
+	efree(key_lens);
+	if (image != NULL) {
+		efree(image);
+	}
+}
+
+/**
+ * Maps a snapshot image and returns a handle for it, or false when the image
+ * is missing or stale
+ */
+PHP_FUNCTION(doctrine_metadata_snapshot_open)
+{
+#ifndef PHP_WIN32
+	char *path, *version;
+	int path_len, version_len, i, fd;
+	const doctrine_metadata_snapshot_header *header;
+	struct stat st;
+	void *image;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "ps", &path, &path_len, &version, &version_len) == FAILURE) {
+		return;
+	}
+
+#ifdef ZTS
+	tsrm_mutex_lock(doctrine_metadata_snapshot_mutex);
+#endif
+
+	for (i = 0; i < doctrine_metadata_snapshots_count; i++) {
+		header = (const doctrine_metadata_snapshot_header *) doctrine_metadata_snapshots[i].image;
+		if (!strcmp(doctrine_metadata_snapshots[i].path, path) && header->version_len == (uint32_t) version_len
+			&& !memcmp(doctrine_metadata_snapshots[i].image + sizeof(doctrine_metadata_snapshot_header), version, version_len)) {
+			RETVAL_LONG(i);
+			goto unlock;
+		}
+	}
+
+	RETVAL_FALSE;
+
+	if (doctrine_metadata_snapshots_count == DOCTRINE_METADATA_SNAPSHOT_MAX || php_check_open_basedir(path TSRMLS_CC)) {
+		goto unlock;
+	}
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		goto unlock;
+	}
+
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(doctrine_metadata_snapshot_header)) {
+		close(fd);
+		goto unlock;
+	}
+
+	image = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (image == MAP_FAILED) {
+		goto unlock;
+	}
+
+	if (!doctrine_metadata_snapshot_valid((const char *) image, st.st_size, version, version_len)) {
+		munmap(image, st.st_size);
+		goto unlock;
+	}
+
+	i = doctrine_metadata_snapshots_count;
+	doctrine_metadata_snapshots[i].path  = strdup(path);
+	doctrine_metadata_snapshots[i].image = (const char *) image;
+	doctrine_metadata_snapshots[i].size  = st.st_size;
+
+	/* The slot must be complete before other threads can see it */
+	__sync_synchronize();
+	doctrine_metadata_snapshots_count = i + 1;
+
+	RETVAL_LONG(i);
+
+unlock:
+#ifdef ZTS
+	tsrm_mutex_unlock(doctrine_metadata_snapshot_mutex);
+#endif
+	return;
+#else
+	RETURN_FALSE;
+#endif
+}
+
+/**
+ * Returns the metadata stored in a snapshot under the given key or false if
+ * there is none
+ */
+PHP_FUNCTION(doctrine_metadata_snapshot_fetch)
+{
+	long handle;
+	char *key;
+	int key_len;
+	uint32_t hash, offset;
+	const char *image;
+	const unsigned char *p;
+	const doctrine_metadata_snapshot_header *header;
+	const doctrine_metadata_snapshot_entry *entry;
+	php_unserialize_data_t var_hash;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "ls", &handle, &key, &key_len) == FAILURE) {
+		return;
+	}
+
+	if (handle < 0 || handle >= doctrine_metadata_snapshots_count) {
+		RETURN_FALSE;
+	}
+
+	image  = doctrine_metadata_snapshots[handle].image;
+	header = (const doctrine_metadata_snapshot_header *) image;
+	hash   = (uint32_t) zend_inline_hash_func(key, key_len);
+	offset = ((const uint32_t *) (image + DOCTRINE_METADATA_SNAPSHOT_BUCKETS_OFFSET(header)))[hash & (header->buckets - 1)];
+
+	while (offset) {
+		entry = (const doctrine_metadata_snapshot_entry *) (image + offset);
+		if (entry->hash == hash && entry->key_len == (uint32_t) key_len && !memcmp(entry->data, key, key_len)) {
+			p = (const unsigned char *) entry->data + entry->key_len;
+			PHP_VAR_UNSERIALIZE_INIT(var_hash);
+			if (!php_var_unserialize(&return_value, &p, p + entry->value_len, &var_hash TSRMLS_CC)) {
+				PHP_VAR_UNSERIALIZE_DESTROY(var_hash);
+				zval_dtor(return_value);
+				RETURN_FALSE;
+			}
+			PHP_VAR_UNSERIALIZE_DESTROY(var_hash);
+			return;
+		}
+		offset = entry->next;
+	}
+
+	RETURN_FALSE;
+}
@@ -0,0 +1,29 @@
+
+#ifndef DOCTRINE_COMMON_PERSISTENCE_MAPPING_METADATASNAPSHOT_H
+#define DOCTRINE_COMMON_PERSISTENCE_MAPPING_METADATASNAPSHOT_H 1
+
+/** Deploy-time compiled metadata images */
+void doctrine_metadata_snapshot_startup(void);
+void doctrine_metadata_snapshot_shutdown(void);
+
+PHP_FUNCTION(doctrine_metadata_snapshot_write);
+PHP_FUNCTION(doctrine_metadata_snapshot_open);
+PHP_FUNCTION(doctrine_metadata_snapshot_fetch);
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_metadata_snapshot_write, 0, 0, 3)
+	ZEND_ARG_INFO(0, path)
+	ZEND_ARG_ARRAY_INFO(0, entries, 0)
+	ZEND_ARG_INFO(0, version)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_metadata_snapshot_open, 0, 0, 2)
+	ZEND_ARG_INFO(0, path)
+	ZEND_ARG_INFO(0, version)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_metadata_snapshot_fetch, 0, 0, 2)
+	ZEND_ARG_INFO(0, snapshot)
+	ZEND_ARG_INFO(0, key)
+ZEND_END_ARG_INFO()
+
+#endif
@@ -0,0 +1,185 @@
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+
+#include "ext/standard/info.h"
+
+#include "kernel/main.h"
+
+#include "doctrine/common/persistence/mapping/metadatastats.h"
+
+#ifndef PHP_WIN32
+#include <time.h>
+#include <sys/time.h>
+#endif
+
+/*
+ * Metadata factory counters
+ *--------------------------
+ *
+ * The factory reports into a fixed array of counters in the module globals,
+ * so recording is an index and two additions with no locking, per thread on
+ * ZTS builds. Timed phases pass the clock value taken when they started and
+ * the elapsed nanoseconds are added to the phase.
+ *
+ * The factory is Zephir code, so each record and each clock reading is still
+ * a PHP function call, a few hundred nanoseconds, which the timed phases
+ * include. The counters are meant to compare runs, not as free profiling.
+ *
+ * Without --enable-doctrine-metadata-stats nothing is kept and
+ * doctrine_metadata_stats_enabled() tells the factory not to call in at all.
+ *
+ * The factory names the counters with the AbstractClassMetadataFactory::STAT_*
+ * constants, which must follow the order of this table.
+ */
+
+static const char *doctrine_metadata_stats_names[DOCTRINE_METADATA_STAT_COUNT] = {
+	"loaded_hits",       /* STAT_LOADED_HITS: answered from loadedMetadata */
+	"local_cache_hits",  /* STAT_LOCAL_CACHE_HITS: answered from the local cache */
+	"cache_hits",        /* STAT_CACHE_HITS: answered from a snapshot, the store or the cache driver */
+	"cache_misses",      /* STAT_CACHE_MISSES: loaded through the driver */
+	"alias_resolutions", /* STAT_ALIAS_RESOLUTIONS: "Alias:ClassName" names resolved */
+	"claim_waits",       /* STAT_CLAIM_WAITS: claims refused because another thread built the entry */
+	"get_metadata_for",  /* STAT_GET_METADATA_FOR: timed, getMetadataFor() past loadedMetadata */
+	"load_metadata",     /* STAT_LOAD_METADATA: timed, loadMetadata() */
+	"do_load_metadata",  /* STAT_DO_LOAD_METADATA: timed, doLoadMetadata() per class */
+	"cache_fetch"        /* STAT_CACHE_FETCH: timed, cache driver fetches */
+};
+
+#define DOCTRINE_METADATA_STAT_FIRST_TIMED 6
+
+/**
+ * Monotonic clock in nanoseconds, truncated to a long; only differences
+ * between two readings are meaningful
+ */
+static inline unsigned long doctrine_metadata_stats_now(void)
+{
+#if defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long) ts.tv_sec * 1000000000UL + (unsigned long) ts.tv_nsec;
+#elif !defined(PHP_WIN32)
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (unsigned long) tv.tv_sec * 1000000000UL + (unsigned long) tv.tv_usec * 1000UL;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * Prints the counters in phpinfo()
+ */
+void doctrine_metadata_stats_minfo(TSRMLS_D)
+{
+#ifdef DOCTRINE_METADATA_STATS
+	int i;
+	char buf[64];
+
+	php_info_print_table_start();
+	php_info_print_table_header(2, "Metadata factory statistics", "enabled");
+	for (i = 0; i < DOCTRINE_METADATA_STAT_COUNT; i++) {
+		if (i < DOCTRINE_METADATA_STAT_FIRST_TIMED) {
+			snprintf(buf, sizeof(buf), "%lu", ZEPHIR_GLOBAL(metadata_stats_count)[i]);
+		} else {
+			snprintf(buf, sizeof(buf), "%lu calls, %lu ns", ZEPHIR_GLOBAL(metadata_stats_count)[i], ZEPHIR_GLOBAL(metadata_stats_time)[i]);
+		}
+		php_info_print_table_row(2, doctrine_metadata_stats_names[i], buf);
+	}
+	php_info_print_table_end();
+#else
+	php_info_print_table_start();
+	php_info_print_table_header(2, "Metadata factory statistics", "disabled");
+	php_info_print_table_end();
+#endif
+}
+
+/**
+ * Whether the counters are compiled in
+ */
+PHP_FUNCTION(doctrine_metadata_stats_enabled)
+{
+#ifdef DOCTRINE_METADATA_STATS
+	RETURN_TRUE;
+#else
+	RETURN_FALSE;
+#endif
+}
+
+/**
+ * Returns the clock value to pass to doctrine_metadata_stats_record()
+ */
+PHP_FUNCTION(doctrine_metadata_stats_clock)
+{
+	RETURN_LONG((long) doctrine_metadata_stats_now());
+}
+
+/**
+ * Counts one event, adding the time elapsed since start when it is given
+ */
+PHP_FUNCTION(doctrine_metadata_stats_record)
+{
+#ifdef DOCTRINE_METADATA_STATS
+	long counter, start = 0;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "l|l", &counter, &start) == FAILURE) {
+		return;
+	}
+
+	if (counter < 0 || counter >= DOCTRINE_METADATA_STAT_COUNT) {
+		return;
+	}
+
+	ZEPHIR_GLOBAL(metadata_stats_count)[counter]++;
+	if (start) {
+		ZEPHIR_GLOBAL(metadata_stats_time)[counter] += doctrine_metadata_stats_now() - (unsigned long) start;
+	}
+#endif
+}
+
+/**
+ * Returns the counters, or false when they are not compiled in
+ */
+PHP_FUNCTION(doctrine_metadata_stats)
+{
+#ifdef DOCTRINE_METADATA_STATS
+	int i;
+	zval *phase;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	array_init_size(return_value, DOCTRINE_METADATA_STAT_COUNT);
+	for (i = 0; i < DOCTRINE_METADATA_STAT_COUNT; i++) {
+		if (i < DOCTRINE_METADATA_STAT_FIRST_TIMED) {
+			add_assoc_long(return_value, doctrine_metadata_stats_names[i], (long) ZEPHIR_GLOBAL(metadata_stats_count)[i]);
+		} else {
+			MAKE_STD_ZVAL(phase);
+			array_init_size(phase, 2);
+			add_assoc_long_ex(phase, SS("count"), (long) ZEPHIR_GLOBAL(metadata_stats_count)[i]);
+			add_assoc_long_ex(phase, SS("time_ns"), (long) ZEPHIR_GLOBAL(metadata_stats_time)[i]);
+			add_assoc_zval(return_value, doctrine_metadata_stats_names[i], phase);
+		}
+	}
+#else
+	RETURN_FALSE;
+#endif
+}
+
+/**
+ * Clears the counters
+ */
+PHP_FUNCTION(doctrine_metadata_stats_reset)
+{
+#ifdef DOCTRINE_METADATA_STATS
+	memset(ZEPHIR_GLOBAL(metadata_stats_count), 0, sizeof(ZEPHIR_GLOBAL(metadata_stats_count)));
+	memset(ZEPHIR_GLOBAL(metadata_stats_time), 0, sizeof(ZEPHIR_GLOBAL(metadata_stats_time)));
+#endif
+}
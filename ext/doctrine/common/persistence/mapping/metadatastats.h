@@ -0,0 +1,22 @@
+
+#ifndef DOCTRINE_COMMON_PERSISTENCE_MAPPING_METADATASTATS_H
+#define DOCTRINE_COMMON_PERSISTENCE_MAPPING_METADATASTATS_H 1
+
+/** Metadata factory counters, compiled in with --enable-doctrine-metadata-stats */
+void doctrine_metadata_stats_minfo(TSRMLS_D);
+
+PHP_FUNCTION(doctrine_metadata_stats_enabled);
+PHP_FUNCTION(doctrine_metadata_stats_clock);
+PHP_FUNCTION(doctrine_metadata_stats_record);
+PHP_FUNCTION(doctrine_metadata_stats);
+PHP_FUNCTION(doctrine_metadata_stats_reset);
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_metadata_stats_none, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_metadata_stats_record, 0, 0, 1)
+	ZEND_ARG_INFO(0, counter)
+	ZEND_ARG_INFO(0, start)
+ZEND_END_ARG_INFO()
+
+#endif
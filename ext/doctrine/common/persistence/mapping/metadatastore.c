@@ -0,0 +1,590 @@
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+
+#include "ext/standard/php_var.h"
+
+#include "kernel/main.h"
+#include "kernel/variables.h"
+
+#include "doctrine/common/persistence/mapping/metadatastore.h"
+
+#ifndef PHP_WIN32
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#if defined(ZTS) && !defined(PHP_WIN32)
+#include <pthread.h>
+#include <sys/time.h>
+# define DOCTRINE_METADATA_STORE_CLAIMS 1
+#endif
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+# define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/*
+ * Process-wide ClassMetadata store
+ *---------------------------------
+ *
+ * An anonymous shared mapping created at MINIT, before the SAPI forks its
+ * workers, so every worker of the same master sees the same segment.
+ *
+ * Entries are serialized ClassMetadata instances keyed by
+ * realClassName . cacheSalt. They are append-only and never modified once
+ * published, so readers do not take the lock: a writer fills the entry
+ * completely and only then links it into its bucket. The store only saves
+ * the cache driver round trip: every fetch still unserializes the whole
+ * entry, in every request that asks for it.
+ *
+ * When the segment is full new entries are refused, counted in "refused",
+ * and the factory falls back to its cache driver.
+ *
+ * Since entries cannot be modified, every key is prefixed with the
+ * doctrine.metadata_store_namespace setting and with a generation counter
+ * kept in the segment. Applications sharing a master set their own
+ * namespace, and doctrine_metadata_store_reset() bumps the generation after
+ * a deployment so that the entries built from the old mapping are no longer
+ * reached. The reset also gives their space back by emptying the segment,
+ * which can only be done while no worker is reading it: readers announce
+ * themselves in a counter, and when some are active the segment is emptied
+ * by the first insert that finds none. A worker killed in the middle of a
+ * fetch leaves the counter raised, and the space is then only given back
+ * when the master restarts.
+ *
+ * The writer lock records the pid of its owner. A writer that cannot get
+ * the lock after DOCTRINE_METADATA_STORE_SPINS tries takes it over if that
+ * worker no longer exists; entries are linked only after the bump pointer
+ * moved past them, so a writer dying at any point leaves at most some
+ * unreachable bytes behind.
+ *
+ * Thread safe builds also keep a table of the keys being built. The first
+ * thread that misses a key claims it and builds the metadata, the others
+ * wait on a condition variable until it is published instead of building
+ * their own copy. Claims are released when the key is saved, when the
+ * claiming thread ends its request, or after DOCTRINE_METADATA_STORE_WAIT
+ * seconds so that a thread waiting on another one cannot deadlock.
+ */
+
+#define DOCTRINE_METADATA_STORE_MAGIC 0x444d5331
+#define DOCTRINE_METADATA_STORE_BUCKETS 2048
+#define DOCTRINE_METADATA_STORE_SPINS 1024
+#define DOCTRINE_METADATA_STORE_WAIT 5
+
+typedef struct _doctrine_metadata_store_entry {
+	uint32_t next;
+	uint32_t key_len;
+	uint32_t value_len;
+	ulong hash;
+	char data[1];
+} doctrine_metadata_store_entry;
+
+typedef struct _doctrine_metadata_store_header {
+	uint32_t magic;
+	volatile int lock;
+	volatile int owner; /**< Pid of the worker holding the lock, 0 while it is free */
+	volatile uint32_t readers; /**< Fetches and claims in progress */
+	volatile int rewinding; /**< Set while a reset waits for readers to leave */
+	int rewind_pending; /**< The segment is to be emptied once no reader is left */
+	size_t size;
+	size_t used;
+	unsigned long entries;
+	unsigned long refused; /**< Entries that did not fit */
+	volatile uint32_t generation;
+	volatile uint32_t buckets[DOCTRINE_METADATA_STORE_BUCKETS];
+} doctrine_metadata_store_header;
+
+static doctrine_metadata_store_header *doctrine_metadata_store = NULL;
+
+#ifdef DOCTRINE_METADATA_STORE_CLAIMS
+static pthread_mutex_t doctrine_metadata_store_claims_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t doctrine_metadata_store_claims_cond = PTHREAD_COND_INITIALIZER;
+
+/* Key => THREAD_T of the thread building it */
+static HashTable doctrine_metadata_store_claims;
+#endif
+
+/**
+ * Maps the store, called once from MINIT
+ */
+int doctrine_metadata_store_init(size_t size)
+{
+#if defined(PHP_WIN32) || !defined(MAP_ANONYMOUS)
+	return FAILURE;
+#else
+	void *segment;
+
+	if (size < sizeof(doctrine_metadata_store_header) || size > UINT32_MAX) {
+		return FAILURE;
+	}
+
+	segment = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (segment == MAP_FAILED) {
+		return FAILURE;
+	}
+
+	doctrine_metadata_store = (doctrine_metadata_store_header *) segment;
+	memset(doctrine_metadata_store, 0, sizeof(doctrine_metadata_store_header));
+
+	doctrine_metadata_store->magic = DOCTRINE_METADATA_STORE_MAGIC;
+	doctrine_metadata_store->size  = size;
+	doctrine_metadata_store->used  = ZEND_MM_ALIGNED_SIZE(sizeof(doctrine_metadata_store_header));
+
+#ifdef DOCTRINE_METADATA_STORE_CLAIMS
+	zend_hash_init(&doctrine_metadata_store_claims, 16, NULL, NULL, 1);
+#endif
+
+	return SUCCESS;
+#endif
+}
+
+/**
+ * Unmaps the store, called once from MSHUTDOWN
+ */
+void doctrine_metadata_store_shutdown(void)
+{
+#if !defined(PHP_WIN32) && defined(MAP_ANONYMOUS)
+	if (doctrine_metadata_store != NULL) {
+#ifdef DOCTRINE_METADATA_STORE_CLAIMS
+		zend_hash_destroy(&doctrine_metadata_store_claims);
+#endif
+		munmap(doctrine_metadata_store, doctrine_metadata_store->size);
+		doctrine_metadata_store = NULL;
+	}
+#endif
+}
+
+int doctrine_metadata_store_enabled(void)
+{
+	return doctrine_metadata_store != NULL;
+}
+
+void doctrine_metadata_store_info(size_t *size, size_t *used, unsigned long *entries, unsigned long *refused)
+{
+	if (doctrine_metadata_store == NULL) {
+		*size = *used = 0;
+		*entries = *refused = 0;
+		return;
+	}
+
+	*size    = doctrine_metadata_store->size;
+	*used    = doctrine_metadata_store->used;
+	*entries = doctrine_metadata_store->entries;
+	*refused = doctrine_metadata_store->refused;
+}
+
+/**
+ * Announces a lock-free reader, fails while a reset is emptying the segment
+ */
+static int doctrine_metadata_store_enter(void)
+{
+	__sync_fetch_and_add(&doctrine_metadata_store->readers, 1);
+	if (doctrine_metadata_store->rewinding) {
+		__sync_fetch_and_sub(&doctrine_metadata_store->readers, 1);
+		return 0;
+	}
+
+	return 1;
+}
+
+static void doctrine_metadata_store_leave(void)
+{
+	__sync_fetch_and_sub(&doctrine_metadata_store->readers, 1);
+}
+
+static const doctrine_metadata_store_entry *doctrine_metadata_store_find(const char *key, uint key_len, ulong h)
+{
+	uint32_t offset;
+	const doctrine_metadata_store_entry *entry;
+
+	offset = doctrine_metadata_store->buckets[h & (DOCTRINE_METADATA_STORE_BUCKETS - 1)];
+	/* Pairs with the barrier in doctrine_metadata_store_insert() */
+	__sync_synchronize();
+
+	while (offset) {
+		entry = (const doctrine_metadata_store_entry *) ((const char *) doctrine_metadata_store + offset);
+		if (entry->hash == h && entry->key_len == key_len && !memcmp(entry->data, key, key_len)) {
+			return entry;
+		}
+		offset = entry->next;
+	}
+
+	return NULL;
+}
+
+/**
+ * Writers only ever spin for a bounded time, then take the lock over from a
+ * worker that died while holding it. Threads of a ZTS build share a pid, so
+ * their owner is never found dead
+ */
+static int doctrine_metadata_store_lock(void)
+{
+#ifndef PHP_WIN32
+	int i;
+	int self = (int) getpid(), owner;
+
+	for (i = 0; i < DOCTRINE_METADATA_STORE_SPINS; i++) {
+		if (!__sync_lock_test_and_set(&doctrine_metadata_store->lock, 1)) {
+			doctrine_metadata_store->owner = self;
+			return 1;
+		}
+		sched_yield();
+	}
+
+	/* 0 while the owner is between taking the lock and recording its pid */
+	owner = doctrine_metadata_store->owner;
+	if (owner > 0 && owner != self && kill((pid_t) owner, 0) == -1 && errno == ESRCH
+		&& __sync_bool_compare_and_swap(&doctrine_metadata_store->owner, owner, self)) {
+		/* The dead worker may have been emptying the segment */
+		if (doctrine_metadata_store->rewinding) {
+			doctrine_metadata_store->rewind_pending = 1;
+			doctrine_metadata_store->rewinding      = 0;
+		}
+		return 1;
+	}
+#endif
+
+	return 0;
+}
+
+static void doctrine_metadata_store_unlock(void)
+{
+	doctrine_metadata_store->owner = 0;
+	__sync_lock_release(&doctrine_metadata_store->lock);
+}
+
+/**
+ * Empties the segment if no reader is in it, or leaves that to the next
+ * insert. Called with the lock held
+ */
+static void doctrine_metadata_store_rewind(void)
+{
+	doctrine_metadata_store->rewinding = 1;
+	/* Pairs with the increment in doctrine_metadata_store_enter() */
+	__sync_synchronize();
+
+	if (doctrine_metadata_store->readers) {
+		doctrine_metadata_store->rewind_pending = 1;
+	} else {
+		memset((void *) doctrine_metadata_store->buckets, 0, sizeof(doctrine_metadata_store->buckets));
+		doctrine_metadata_store->used           = ZEND_MM_ALIGNED_SIZE(sizeof(doctrine_metadata_store_header));
+		doctrine_metadata_store->entries        = 0;
+		doctrine_metadata_store->rewind_pending = 0;
+	}
+
+	__sync_synchronize();
+	doctrine_metadata_store->rewinding = 0;
+}
+
+static int doctrine_metadata_store_insert(const char *key, uint key_len, const char *value, uint value_len)
+{
+	ulong h;
+	uint32_t slot, offset;
+	size_t needed;
+	doctrine_metadata_store_entry *entry;
+
+	h = zend_inline_hash_func(key, key_len);
+	slot = h & (DOCTRINE_METADATA_STORE_BUCKETS - 1);
+	needed = ZEND_MM_ALIGNED_SIZE(XtOffsetOf(doctrine_metadata_store_entry, data) + key_len + value_len);
+
+	if (!doctrine_metadata_store_lock()) {
+		return FAILURE;
+	}
+
+	if (doctrine_metadata_store->rewind_pending) {
+		doctrine_metadata_store_rewind();
+	}
+
+	/* Entries are immutable, the first writer wins */
+	if (doctrine_metadata_store_find(key, key_len, h) != NULL) {
+		doctrine_metadata_store_unlock();
+		return SUCCESS;
+	}
+
+	if (doctrine_metadata_store->used + needed > doctrine_metadata_store->size) {
+		doctrine_metadata_store->refused++;
+		doctrine_metadata_store_unlock();
+		return FAILURE;
+	}
+
+	offset = (uint32_t) doctrine_metadata_store->used;
+	entry = (doctrine_metadata_store_entry *) ((char *) doctrine_metadata_store + offset);
+	entry->next      = doctrine_metadata_store->buckets[slot];
+	entry->key_len   = key_len;
+	entry->value_len = value_len;
+	entry->hash      = h;
+	memcpy(entry->data, key, key_len);
+	memcpy(entry->data + key_len, value, value_len);
+
+	/* Claim the space first, a writer taking over the lock must not reuse it */
+	doctrine_metadata_store->used += needed;
+	doctrine_metadata_store->entries++;
+
+	/* The entry must be complete before readers can reach it */
+	__sync_synchronize();
+	doctrine_metadata_store->buckets[slot] = offset;
+
+	doctrine_metadata_store_unlock();
+	return SUCCESS;
+}
+
+/**
+ * Lock-free lookup of a key, for the claims
+ */
+static int doctrine_metadata_store_published(const char *key, uint key_len, ulong h)
+{
+	int found;
+
+	if (!doctrine_metadata_store_enter()) {
+		return 0;
+	}
+	found = doctrine_metadata_store_find(key, key_len, h) != NULL;
+	doctrine_metadata_store_leave();
+
+	return found;
+}
+
+/**
+ * Builds the key an entry is stored under: namespace:generation:key
+ */
+static char *doctrine_metadata_store_key(const char *key, int key_len, int *full_len TSRMLS_DC)
+{
+	char *full;
+
+	*full_len = spprintf(&full, 0, "%s:%u:%.*s", INI_STR("doctrine.metadata_store_namespace"), doctrine_metadata_store->generation, key_len, key);
+	return full;
+}
+
+#ifdef DOCTRINE_METADATA_STORE_CLAIMS
+
+/**
+ * Drops the claim on a key if the current thread holds it and wakes up the
+ * threads waiting for it
+ */
+static void doctrine_metadata_store_release(const char *key, uint key_len, ulong h)
+{
+	THREAD_T *owner;
+	THREAD_T self = tsrm_thread_id();
+
+	pthread_mutex_lock(&doctrine_metadata_store_claims_mutex);
+	if (zend_hash_quick_find(&doctrine_metadata_store_claims, key, key_len + 1, h, (void **) &owner) == SUCCESS && *owner == self) {
+		zend_hash_quick_del(&doctrine_metadata_store_claims, key, key_len + 1, h);
+		pthread_cond_broadcast(&doctrine_metadata_store_claims_cond);
+	}
+	pthread_mutex_unlock(&doctrine_metadata_store_claims_mutex);
+}
+
+static int doctrine_metadata_store_release_owned(void *pDest, void *argument TSRMLS_DC)
+{
+	return *((THREAD_T *) pDest) == *((THREAD_T *) argument) ? ZEND_HASH_APPLY_REMOVE : ZEND_HASH_APPLY_KEEP;
+}
+
+#endif
+
+/**
+ * Releases the claims the current thread still holds, called from
+ * RSHUTDOWN so that a request aborted while building metadata does not make
+ * the other threads wait
+ */
+void doctrine_metadata_store_release_claims(TSRMLS_D)
+{
+#ifdef DOCTRINE_METADATA_STORE_CLAIMS
+	THREAD_T self;
+
+	if (doctrine_metadata_store == NULL) {
+		return;
+	}
+
+	self = tsrm_thread_id();
+	pthread_mutex_lock(&doctrine_metadata_store_claims_mutex);
+	if (zend_hash_num_elements(&doctrine_metadata_store_claims)) {
+		zend_hash_apply_with_argument(&doctrine_metadata_store_claims, doctrine_metadata_store_release_owned, &self TSRMLS_CC);
+		pthread_cond_broadcast(&doctrine_metadata_store_claims_cond);
+	}
+	pthread_mutex_unlock(&doctrine_metadata_store_claims_mutex);
+#endif
+}
+
+/**
+ * Claims the right to build the metadata stored under the given key.
+ *
+ * Returns false when the key is published, possibly after waiting for the
+ * thread that claimed it first, and true when the caller has to build it
+ * and save it. Without a store or outside of thread safe builds every
+ * caller builds its own copy.
+ */
+PHP_FUNCTION(doctrine_metadata_store_claim)
+{
+	char *name, *key;
+	int name_len, key_len;
+	ulong h;
+#ifdef DOCTRINE_METADATA_STORE_CLAIMS
+	THREAD_T self, *owner;
+	struct timeval now;
+	struct timespec deadline;
+#endif
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "s", &name, &name_len) == FAILURE) {
+		return;
+	}
+
+	if (doctrine_metadata_store == NULL) {
+		RETURN_TRUE;
+	}
+
+	key = doctrine_metadata_store_key(name, name_len, &key_len TSRMLS_CC);
+	h = zend_inline_hash_func(key, key_len);
+	if (doctrine_metadata_store_published(key, key_len, h)) {
+		efree(key);
+		RETURN_FALSE;
+	}
+
+#ifdef DOCTRINE_METADATA_STORE_CLAIMS
+	self = tsrm_thread_id();
+	gettimeofday(&now, NULL);
+	deadline.tv_sec  = now.tv_sec + DOCTRINE_METADATA_STORE_WAIT;
+	deadline.tv_nsec = now.tv_usec * 1000;
+
+	pthread_mutex_lock(&doctrine_metadata_store_claims_mutex);
+	while (zend_hash_quick_find(&doctrine_metadata_store_claims, key, key_len + 1, h, (void **) &owner) == SUCCESS && *owner != self) {
+		if (pthread_cond_timedwait(&doctrine_metadata_store_claims_cond, &doctrine_metadata_store_claims_mutex, &deadline) != 0) {
+			/* Build it without claiming it, the owner keeps its claim */
+			pthread_mutex_unlock(&doctrine_metadata_store_claims_mutex);
+			efree(key);
+			RETURN_TRUE;
+		}
+		if (doctrine_metadata_store_published(key, key_len, h)) {
+			pthread_mutex_unlock(&doctrine_metadata_store_claims_mutex);
+			efree(key);
+			RETURN_FALSE;
+		}
+	}
+
+	/* Published between the lookup above and taking the mutex */
+	if (doctrine_metadata_store_published(key, key_len, h)) {
+		pthread_mutex_unlock(&doctrine_metadata_store_claims_mutex);
+		efree(key);
+		RETURN_FALSE;
+	}
+
+	zend_hash_quick_update(&doctrine_metadata_store_claims, key, key_len + 1, h, &self, sizeof(THREAD_T), NULL);
+	pthread_mutex_unlock(&doctrine_metadata_store_claims_mutex);
+#endif
+
+	efree(key);
+	RETURN_TRUE;
+}
+
+/**
+ * Returns the metadata stored under the given key or false if there is none.
+ * The entry is unserialized on every call
+ */
+PHP_FUNCTION(doctrine_metadata_store_fetch)
+{
+	char *name, *key;
+	int name_len, key_len;
+	const unsigned char *p;
+	const doctrine_metadata_store_entry *entry;
+	php_unserialize_data_t var_hash;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "s", &name, &name_len) == FAILURE) {
+		return;
+	}
+
+	if (doctrine_metadata_store == NULL) {
+		RETURN_FALSE;
+	}
+
+	if (!doctrine_metadata_store_enter()) {
+		RETURN_FALSE;
+	}
+
+	/* The entry must stay in place until it is unserialized */
+	key = doctrine_metadata_store_key(name, name_len, &key_len TSRMLS_CC);
+	entry = doctrine_metadata_store_find(key, key_len, zend_inline_hash_func(key, key_len));
+	efree(key);
+	if (entry == NULL) {
+		doctrine_metadata_store_leave();
+		RETURN_FALSE;
+	}
+
+	p = (const unsigned char *) entry->data + entry->key_len;
+	PHP_VAR_UNSERIALIZE_INIT(var_hash);
+	if (!php_var_unserialize(&return_value, &p, p + entry->value_len, &var_hash TSRMLS_CC)) {
+		PHP_VAR_UNSERIALIZE_DESTROY(var_hash);
+		doctrine_metadata_store_leave();
+		zval_dtor(return_value);
+		RETURN_FALSE;
+	}
+	PHP_VAR_UNSERIALIZE_DESTROY(var_hash);
+	doctrine_metadata_store_leave();
+}
+
+/**
+ * Publishes the metadata under the given key, existing entries are kept
+ */
+PHP_FUNCTION(doctrine_metadata_store_save)
+{
+	char *name, *key;
+	int name_len, key_len;
+	zval *value, serialized;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "sz", &name, &name_len, &value) == FAILURE) {
+		return;
+	}
+
+	if (doctrine_metadata_store == NULL) {
+		RETURN_FALSE;
+	}
+
+	INIT_ZVAL(serialized);
+	zephir_serialize(&serialized, &value TSRMLS_CC);
+	if (Z_TYPE(serialized) != IS_STRING) {
+		zval_dtor(&serialized);
+		RETURN_FALSE;
+	}
+
+	key = doctrine_metadata_store_key(name, name_len, &key_len TSRMLS_CC);
+	RETVAL_BOOL(doctrine_metadata_store_insert(key, key_len, Z_STRVAL(serialized), Z_STRLEN(serialized)) == SUCCESS);
+	zval_dtor(&serialized);
+
+#ifdef DOCTRINE_METADATA_STORE_CLAIMS
+	/* Waiters retry the lookup, and claim the key if the store was full */
+	doctrine_metadata_store_release(key, key_len, zend_inline_hash_func(key, key_len));
+#endif
+	efree(key);
+}
+
+/**
+ * Makes every entry saved so far unreachable, in all the workers, and gives
+ * their space back. Returns false when there is no store
+ */
+PHP_FUNCTION(doctrine_metadata_store_reset)
+{
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	if (doctrine_metadata_store == NULL) {
+		RETURN_FALSE;
+	}
+
+	__sync_fetch_and_add(&doctrine_metadata_store->generation, 1);
+
+	if (doctrine_metadata_store_lock()) {
+		doctrine_metadata_store_rewind();
+		doctrine_metadata_store_unlock();
+	} else {
+		doctrine_metadata_store->rewind_pending = 1;
+	}
+
+	RETURN_TRUE;
+}
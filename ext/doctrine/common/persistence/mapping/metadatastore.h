@@ -0,0 +1,33 @@
+
+#ifndef DOCTRINE_COMMON_PERSISTENCE_MAPPING_METADATASTORE_H
+#define DOCTRINE_COMMON_PERSISTENCE_MAPPING_METADATASTORE_H 1
+
+/** Process-wide ClassMetadata store */
+int doctrine_metadata_store_init(size_t size);
+void doctrine_metadata_store_shutdown(void);
+int doctrine_metadata_store_enabled(void);
+void doctrine_metadata_store_info(size_t *size, size_t *used, unsigned long *entries, unsigned long *refused);
+void doctrine_metadata_store_release_claims(TSRMLS_D);
+
+PHP_FUNCTION(doctrine_metadata_store_claim);
+PHP_FUNCTION(doctrine_metadata_store_fetch);
+PHP_FUNCTION(doctrine_metadata_store_save);
+PHP_FUNCTION(doctrine_metadata_store_reset);
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_metadata_store_claim, 0, 0, 1)
+	ZEND_ARG_INFO(0, key)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_metadata_store_fetch, 0, 0, 1)
+	ZEND_ARG_INFO(0, key)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_metadata_store_save, 0, 0, 2)
+	ZEND_ARG_INFO(0, key)
+	ZEND_ARG_INFO(0, value)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_metadata_store_reset, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+#endif
@@ -0,0 +1,355 @@
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+#include "doctrine.h"
+
+#include "Zend/zend_interfaces.h"
+#include "ext/reflection/php_reflection.h"
+
+#include "kernel/main.h"
+
+/*
+ * Property handles
+ *-----------------
+ *
+ * A lighter replacement for an accessible ReflectionProperty: a handle
+ * refers to the declaring class entry and the slot of the property in the
+ * object's property table, and reads or writes that slot directly,
+ * whatever the visibility of the property.
+ *
+ * Class entries of user classes only live for one request, so handles are
+ * per request: PropertyHandle::get() returns the same handle for the same
+ * property until the request ends, and nothing about the property is kept
+ * across requests.
+ */
+
+typedef struct _doctrine_property_handle {
+	zend_object std;
+	zend_class_entry *ce;
+	zend_property_info *info;
+	char *name;
+	int name_len;
+} doctrine_property_handle;
+
+static zend_object_handlers doctrine_property_handle_handlers;
+
+#define DOCTRINE_PROPERTY_HANDLE_FETCH() \
+	((doctrine_property_handle *) zend_object_store_get_object(getThis() TSRMLS_CC))
+
+/* Handles only come from PropertyHandle::get(), this catches anything else */
+#define DOCTRINE_PROPERTY_HANDLE_CHECK_INIT(intern) \
+	if (UNEXPECTED((intern)->info == NULL)) { \
+		zend_throw_exception_ex(reflection_exception_ptr, 0 TSRMLS_CC, "Property handles must be obtained from PropertyHandle::get()"); \
+		return; \
+	}
+
+void doctrine_property_handle_init(zend_doctrine_globals *doctrine_globals_ptr)
+{
+	doctrine_globals_ptr->property_handles = NULL;
+}
+
+/**
+ * Drops the handles of the request, called from RSHUTDOWN
+ */
+void doctrine_property_handle_release(TSRMLS_D)
+{
+	HashTable *handles = ZEPHIR_GLOBAL(property_handles);
+
+	if (handles != NULL) {
+		ZEPHIR_GLOBAL(property_handles) = NULL;
+		zend_hash_destroy(handles);
+		FREE_HASHTABLE(handles);
+	}
+}
+
+static void doctrine_property_handle_free(void *object TSRMLS_DC)
+{
+	doctrine_property_handle *intern = (doctrine_property_handle *) object;
+
+	if (intern->name != NULL) {
+		efree(intern->name);
+	}
+
+	zend_object_std_dtor(&intern->std TSRMLS_CC);
+	efree(intern);
+}
+
+static zend_object_value doctrine_property_handle_create(zend_class_entry *ce TSRMLS_DC)
+{
+	zend_object_value retval;
+	doctrine_property_handle *intern;
+
+	intern = (doctrine_property_handle *) ecalloc(1, sizeof(doctrine_property_handle));
+	zend_object_std_init(&intern->std, ce TSRMLS_CC);
+#if PHP_VERSION_ID >= 50400
+	object_properties_init(&intern->std, ce);
+#endif
+
+	retval.handle = zend_objects_store_put(intern, (zend_objects_store_dtor_t) zend_objects_destroy_object, doctrine_property_handle_free, NULL TSRMLS_CC);
+	retval.handlers = &doctrine_property_handle_handlers;
+
+	return retval;
+}
+
+/**
+ * Finds the property info of a property in the class entry of the request.
+ * Like ReflectionClass::getProperty() it reads properties_info directly, the
+ * visibility checks of zend_get_property_info() would hide private ones
+ */
+static zend_property_info *doctrine_property_handle_lookup(zend_class_entry *ce, const char *name, int name_len TSRMLS_DC)
+{
+	zend_property_info *info;
+
+	if (zend_hash_find(&ce->properties_info, name, name_len + 1, (void **) &info) == FAILURE) {
+		return NULL;
+	}
+
+	return info;
+}
+
+#if PHP_VERSION_ID >= 50400
+/**
+ * Returns the slot of the property in the object, NULL if it was unset
+ */
+static zend_always_inline zval **doctrine_property_handle_slot(doctrine_property_handle *intern, zval *object TSRMLS_DC)
+{
+	zend_object *zobj = zend_objects_get_address(object TSRMLS_CC);
+	int offset = intern->info->offset;
+
+	if (UNEXPECTED(offset < 0 || offset >= zobj->ce->default_properties_count)) {
+		return NULL;
+	}
+
+	if (zobj->properties) {
+		return (zval **) zobj->properties_table[offset];
+	}
+
+	return zobj->properties_table[offset] ? &zobj->properties_table[offset] : NULL;
+}
+#endif
+
+static int doctrine_property_handle_check(doctrine_property_handle *intern, zval *object TSRMLS_DC)
+{
+	if (UNEXPECTED(Z_OBJ_HT_P(object)->get_class_entry == NULL || !instanceof_function(Z_OBJCE_P(object), intern->ce TSRMLS_CC))) {
+		zend_throw_exception_ex(reflection_exception_ptr, 0 TSRMLS_CC, "Given object is not an instance of the class this property was declared in");
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/**
+ * Class Doctrine\Common\Reflection\PropertyHandle
+ */
+ZEPHIR_INIT_CLASS(Doctrine_Common_Reflection_PropertyHandle) {
+
+	ZEPHIR_REGISTER_CLASS(Doctrine\\Common\\Reflection, PropertyHandle, doctrine, common_reflection_propertyhandle, doctrine_common_reflection_propertyhandle_method_entry, ZEND_ACC_FINAL_CLASS);
+
+	doctrine_common_reflection_propertyhandle_ce->create_object = doctrine_property_handle_create;
+	doctrine_common_reflection_propertyhandle_ce->serialize     = zend_class_serialize_deny;
+	doctrine_common_reflection_propertyhandle_ce->unserialize   = zend_class_unserialize_deny;
+
+	memcpy(&doctrine_property_handle_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+	doctrine_property_handle_handlers.clone_obj = NULL;
+
+	return SUCCESS;
+
+}
+
+/**
+ * Private, handles are obtained from PropertyHandle::get()
+ */
+PHP_METHOD(Doctrine_Common_Reflection_PropertyHandle, __construct) {
+
+}
+
+/**
+ * Returns the handle of a property, the same one for the whole request
+ *
+ * @param string className
+ * @param string propertyName
+ * @return PropertyHandle
+ */
+PHP_METHOD(Doctrine_Common_Reflection_PropertyHandle, get) {
+
+	char *class_name, *name, *key;
+	int class_name_len, name_len, key_len;
+	zval **cached, *handle;
+	zend_class_entry **pce;
+	zend_property_info *info;
+	doctrine_property_handle *intern;
+	HashTable *handles = ZEPHIR_GLOBAL(property_handles);
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "ss", &class_name, &class_name_len, &name, &name_len) == FAILURE) {
+		return;
+	}
+
+	key_len = spprintf(&key, 0, "%s::%s", class_name, name);
+
+	if (handles != NULL && zend_hash_find(handles, key, key_len + 1, (void **) &cached) == SUCCESS) {
+		efree(key);
+		RETURN_ZVAL(*cached, 1, 0);
+	}
+
+	if (zend_lookup_class(class_name, class_name_len, &pce TSRMLS_CC) == FAILURE) {
+		efree(key);
+		zend_throw_exception_ex(reflection_exception_ptr, 0 TSRMLS_CC, "Class %s does not exist", class_name);
+		return;
+	}
+
+	info = doctrine_property_handle_lookup(*pce, name, name_len TSRMLS_CC);
+	if (info == NULL || (info->flags & ZEND_ACC_STATIC)) {
+		efree(key);
+		zend_throw_exception_ex(reflection_exception_ptr, 0 TSRMLS_CC, "Property %s::$%s does not exist or is static", class_name, name);
+		return;
+	}
+
+	MAKE_STD_ZVAL(handle);
+	object_init_ex(handle, doctrine_common_reflection_propertyhandle_ce);
+
+	intern = (doctrine_property_handle *) zend_object_store_get_object(handle TSRMLS_CC);
+	intern->ce       = info->ce;
+	intern->info     = info;
+	intern->name     = estrndup(name, name_len);
+	intern->name_len = name_len;
+
+	if (handles == NULL) {
+		ALLOC_HASHTABLE(handles);
+		zend_hash_init(handles, 64, NULL, ZVAL_PTR_DTOR, 0);
+		ZEPHIR_GLOBAL(property_handles) = handles;
+	}
+
+	zend_hash_update(handles, key, key_len + 1, &handle, sizeof(zval *), NULL);
+	efree(key);
+
+	RETURN_ZVAL(handle, 1, 0);
+}
+
+/**
+ * Gets the property name
+ *
+ * @return string
+ */
+PHP_METHOD(Doctrine_Common_Reflection_PropertyHandle, getName) {
+
+	doctrine_property_handle *intern = DOCTRINE_PROPERTY_HANDLE_FETCH();
+
+	DOCTRINE_PROPERTY_HANDLE_CHECK_INIT(intern);
+	RETURN_STRINGL(intern->name, intern->name_len, 1);
+}
+
+/**
+ * Gets the name of the class that declares the property
+ *
+ * @return string
+ */
+PHP_METHOD(Doctrine_Common_Reflection_PropertyHandle, getClassName) {
+
+	doctrine_property_handle *intern = DOCTRINE_PROPERTY_HANDLE_FETCH();
+
+	DOCTRINE_PROPERTY_HANDLE_CHECK_INIT(intern);
+	RETURN_STRINGL(intern->ce->name, intern->ce->name_length, 1);
+}
+
+/**
+ * Reads the property of an object, whatever its visibility
+ *
+ * @param object object
+ * @return mixed
+ */
+PHP_METHOD(Doctrine_Common_Reflection_PropertyHandle, getValue) {
+
+	zval *object, *value;
+	doctrine_property_handle *intern = DOCTRINE_PROPERTY_HANDLE_FETCH();
+#if PHP_VERSION_ID >= 50400
+	zval **slot;
+#endif
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "o", &object) == FAILURE) {
+		return;
+	}
+
+	DOCTRINE_PROPERTY_HANDLE_CHECK_INIT(intern);
+
+	if (doctrine_property_handle_check(intern, object TSRMLS_CC) == FAILURE) {
+		return;
+	}
+
+#if PHP_VERSION_ID >= 50400
+	slot = doctrine_property_handle_slot(intern, object TSRMLS_CC);
+	if (EXPECTED(slot != NULL && *slot != NULL)) {
+		RETURN_ZVAL(*slot, 1, 0);
+	}
+#endif
+
+	/* Unset properties go through the handlers in the declaring scope */
+	value = zend_read_property(intern->ce, object, intern->name, intern->name_len, 1 TSRMLS_CC);
+	RETURN_ZVAL(value, 1, 0);
+}
+
+/**
+ * Writes the property of an object, whatever its visibility
+ *
+ * @param object object
+ * @param mixed value
+ */
+PHP_METHOD(Doctrine_Common_Reflection_PropertyHandle, setValue) {
+
+	zval *object, *value;
+	doctrine_property_handle *intern = DOCTRINE_PROPERTY_HANDLE_FETCH();
+#if PHP_VERSION_ID >= 50400
+	zval **slot, *old;
+#endif
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "oz", &object, &value) == FAILURE) {
+		return;
+	}
+
+	DOCTRINE_PROPERTY_HANDLE_CHECK_INIT(intern);
+
+	if (doctrine_property_handle_check(intern, object TSRMLS_CC) == FAILURE) {
+		return;
+	}
+
+#if PHP_VERSION_ID >= 50400
+	slot = doctrine_property_handle_slot(intern, object TSRMLS_CC);
+	if (EXPECTED(slot != NULL && *slot != NULL)) {
+		old = *slot;
+		if (PZVAL_IS_REF(old)) {
+			/* Keep the reference, replace what it points to */
+			zval garbage = *old;
+
+			old->value = value->value;
+			Z_TYPE_P(old) = Z_TYPE_P(value);
+			zval_copy_ctor(old);
+			zval_dtor(&garbage);
+		} else {
+			Z_ADDREF_P(value);
+			*slot = value;
+			zval_ptr_dtor(&old);
+		}
+		return;
+	}
+#endif
+
+	zend_update_property(intern->ce, object, intern->name, intern->name_len, value TSRMLS_CC);
+}
+
+/**
+ * Does nothing, handles are always accessible. Kept so a handle can stand
+ * in for a ReflectionProperty.
+ *
+ * @param bool accessible
+ */
+PHP_METHOD(Doctrine_Common_Reflection_PropertyHandle, setAccessible) {
+
+	zend_bool accessible;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "b", &accessible) == FAILURE) {
+		return;
+	}
+}
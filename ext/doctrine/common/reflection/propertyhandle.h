@@ -0,0 +1,44 @@
+
+extern zend_class_entry *doctrine_common_reflection_propertyhandle_ce;
+
+ZEPHIR_INIT_CLASS(Doctrine_Common_Reflection_PropertyHandle);
+
+void doctrine_property_handle_init(zend_doctrine_globals *doctrine_globals_ptr);
+void doctrine_property_handle_release(TSRMLS_D);
+
+PHP_METHOD(Doctrine_Common_Reflection_PropertyHandle, __construct);
+PHP_METHOD(Doctrine_Common_Reflection_PropertyHandle, get);
+PHP_METHOD(Doctrine_Common_Reflection_PropertyHandle, getName);
+PHP_METHOD(Doctrine_Common_Reflection_PropertyHandle, getClassName);
+PHP_METHOD(Doctrine_Common_Reflection_PropertyHandle, getValue);
+PHP_METHOD(Doctrine_Common_Reflection_PropertyHandle, setValue);
+PHP_METHOD(Doctrine_Common_Reflection_PropertyHandle, setAccessible);
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_common_reflection_propertyhandle_get, 0, 0, 2)
+	ZEND_ARG_INFO(0, className)
+	ZEND_ARG_INFO(0, propertyName)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_common_reflection_propertyhandle_getvalue, 0, 0, 1)
+	ZEND_ARG_INFO(0, object)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_common_reflection_propertyhandle_setvalue, 0, 0, 2)
+	ZEND_ARG_INFO(0, object)
+	ZEND_ARG_INFO(0, value)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_common_reflection_propertyhandle_setaccessible, 0, 0, 1)
+	ZEND_ARG_INFO(0, accessible)
+ZEND_END_ARG_INFO()
+
+ZEPHIR_INIT_FUNCS(doctrine_common_reflection_propertyhandle_method_entry) {
+	PHP_ME(Doctrine_Common_Reflection_PropertyHandle, __construct, NULL, ZEND_ACC_PRIVATE|ZEND_ACC_CTOR)
+	PHP_ME(Doctrine_Common_Reflection_PropertyHandle, get, arginfo_doctrine_common_reflection_propertyhandle_get, ZEND_ACC_PUBLIC|ZEND_ACC_STATIC)
+	PHP_ME(Doctrine_Common_Reflection_PropertyHandle, getName, NULL, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_Common_Reflection_PropertyHandle, getClassName, NULL, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_Common_Reflection_PropertyHandle, getValue, arginfo_doctrine_common_reflection_propertyhandle_getvalue, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_Common_Reflection_PropertyHandle, setValue, arginfo_doctrine_common_reflection_propertyhandle_setvalue, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_Common_Reflection_PropertyHandle, setAccessible, arginfo_doctrine_common_reflection_propertyhandle_setaccessible, ZEND_ACC_PUBLIC)
+	PHP_FE_END
+};
@@ -0,0 +1,175 @@
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+#include "php_ini.h"
+
+#include "kernel/main.h"
+
+#include "doctrine/common/util/realclass.h"
+
+/*
+ * Real class names
+ *-----------------
+ *
+ * ClassUtils::getRealClass() is called for every document during a flush,
+ * almost always with the same few class names. The real class name is
+ * whatever follows the last proxy marker. The resolved names are kept in a
+ * persistent table that lives in the module globals, so it survives across
+ * requests and every thread of a ZTS build has its own copy without any
+ * locking.
+ *
+ * Class names that are not proxies, by far the common case, only record
+ * that fact and the caller gets its own (usually interned) string back.
+ * A hit saves the scan but not the copy of a proxy's real name, PHP 5
+ * strings are not refcounted. The table is bounded: it is emptied when it
+ * reaches its capacity. doctrine.real_class_cache=0 disables it, to compare
+ * both with benchmarks/metadata-factory.
+ */
+
+#define DOCTRINE_REAL_CLASS_CACHE_SIZE 4096
+
+#define DOCTRINE_PROXY_MARKER "\\__CG__\\"
+
+typedef struct _doctrine_real_class {
+	char *name;
+	uint name_len;
+} doctrine_real_class;
+
+static void doctrine_real_class_dtor(void *data)
+{
+	doctrine_real_class *entry = (doctrine_real_class *) data;
+
+	if (entry->name != NULL) {
+		pefree(entry->name, 1);
+	}
+}
+
+void doctrine_real_class_cache_init(zend_doctrine_globals *doctrine_globals_ptr)
+{
+	doctrine_globals_ptr->real_class_cache = (HashTable *) pemalloc(sizeof(HashTable), 1);
+	zend_hash_init(doctrine_globals_ptr->real_class_cache, 64, NULL, doctrine_real_class_dtor, 1);
+
+	doctrine_globals_ptr->real_class_cache_enabled = 1;
+	doctrine_globals_ptr->real_class_hits          = 0;
+	doctrine_globals_ptr->real_class_misses        = 0;
+}
+
+void doctrine_real_class_cache_destroy(zend_doctrine_globals *doctrine_globals_ptr)
+{
+	if (doctrine_globals_ptr->real_class_cache != NULL) {
+		zend_hash_destroy(doctrine_globals_ptr->real_class_cache);
+		pefree(doctrine_globals_ptr->real_class_cache, 1);
+		doctrine_globals_ptr->real_class_cache = NULL;
+	}
+}
+
+/**
+ * Reads doctrine.real_class_cache once per request rather than per call
+ */
+void doctrine_real_class_cache_rinit(TSRMLS_D)
+{
+	ZEPHIR_GLOBAL(real_class_cache_enabled) = INI_BOOL("doctrine.real_class_cache") ? 1 : 0;
+}
+
+/**
+ * Returns the offset of the real class name after the last proxy marker,
+ * or 0 if the class name is not a proxy
+ */
+static uint doctrine_real_class_offset(const char *name, uint name_len)
+{
+	uint i, marker_len = sizeof(DOCTRINE_PROXY_MARKER) - 1;
+
+	if (name_len < marker_len) {
+		return 0;
+	}
+
+	for (i = name_len - marker_len + 1; i-- > 0; ) {
+		if (name[i] == '\\' && !memcmp(name + i, DOCTRINE_PROXY_MARKER, marker_len)) {
+			return i + marker_len;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Gets the real class name of a class name that could be a proxy
+ */
+PHP_FUNCTION(doctrine_get_real_class)
+{
+	zval *class_name;
+	ulong h;
+	uint offset;
+	HashTable *cache;
+	doctrine_real_class *entry, new_entry;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "z", &class_name) == FAILURE) {
+		return;
+	}
+
+	if (Z_TYPE_P(class_name) != IS_STRING) {
+		RETURN_ZVAL(class_name, 1, 0);
+	}
+
+	if (!ZEPHIR_GLOBAL(real_class_cache_enabled)) {
+		offset = doctrine_real_class_offset(Z_STRVAL_P(class_name), Z_STRLEN_P(class_name));
+		if (!offset) {
+			RETURN_ZVAL(class_name, 1, 0);
+		}
+		RETURN_STRINGL(Z_STRVAL_P(class_name) + offset, Z_STRLEN_P(class_name) - offset, 1);
+	}
+
+	cache = ZEPHIR_GLOBAL(real_class_cache);
+	h = zend_inline_hash_func(Z_STRVAL_P(class_name), Z_STRLEN_P(class_name) + 1);
+
+	if (zend_hash_quick_find(cache, Z_STRVAL_P(class_name), Z_STRLEN_P(class_name) + 1, h, (void **) &entry) == SUCCESS) {
+		ZEPHIR_GLOBAL(real_class_hits)++;
+	} else {
+		ZEPHIR_GLOBAL(real_class_misses)++;
+
+		if (zend_hash_num_elements(cache) >= DOCTRINE_REAL_CLASS_CACHE_SIZE) {
+			zend_hash_clean(cache);
+		}
+
+		offset = doctrine_real_class_offset(Z_STRVAL_P(class_name), Z_STRLEN_P(class_name));
+		if (offset) {
+			new_entry.name_len = Z_STRLEN_P(class_name) - offset;
+			new_entry.name     = pestrndup(Z_STRVAL_P(class_name) + offset, new_entry.name_len, 1);
+		} else {
+			new_entry.name_len = 0;
+			new_entry.name     = NULL;
+		}
+
+		if (zend_hash_quick_add(cache, Z_STRVAL_P(class_name), Z_STRLEN_P(class_name) + 1, h, &new_entry, sizeof(doctrine_real_class), (void **) &entry) == FAILURE) {
+			doctrine_real_class_dtor(&new_entry);
+			RETURN_STRINGL(Z_STRVAL_P(class_name) + offset, Z_STRLEN_P(class_name) - offset, 1);
+		}
+	}
+
+	if (entry->name == NULL) {
+		RETURN_ZVAL(class_name, 1, 0);
+	}
+
+	RETURN_STRINGL(entry->name, entry->name_len, 1);
+}
+
+/**
+ * Returns the counters of the real class name table
+ */
+PHP_FUNCTION(doctrine_real_class_cache_info)
+{
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	array_init_size(return_value, 5);
+	add_assoc_bool_ex(return_value, SS("enabled"), ZEPHIR_GLOBAL(real_class_cache_enabled));
+	add_assoc_long_ex(return_value, SS("hits"), (long) ZEPHIR_GLOBAL(real_class_hits));
+	add_assoc_long_ex(return_value, SS("misses"), (long) ZEPHIR_GLOBAL(real_class_misses));
+	add_assoc_long_ex(return_value, SS("entries"), (long) zend_hash_num_elements(ZEPHIR_GLOBAL(real_class_cache)));
+	add_assoc_long_ex(return_value, SS("capacity"), DOCTRINE_REAL_CLASS_CACHE_SIZE);
+}
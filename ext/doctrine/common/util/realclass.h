@@ -0,0 +1,20 @@
+
+#ifndef DOCTRINE_COMMON_UTIL_REALCLASS_H
+#define DOCTRINE_COMMON_UTIL_REALCLASS_H 1
+
+/** Native ClassUtils::getRealClass() and its per-process memo */
+void doctrine_real_class_cache_init(zend_doctrine_globals *doctrine_globals_ptr);
+void doctrine_real_class_cache_destroy(zend_doctrine_globals *doctrine_globals_ptr);
+void doctrine_real_class_cache_rinit(TSRMLS_D);
+
+PHP_FUNCTION(doctrine_get_real_class);
+PHP_FUNCTION(doctrine_real_class_cache_info);
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_get_real_class, 0, 0, 1)
+	ZEND_ARG_INFO(0, className)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_real_class_cache_info, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+#endif
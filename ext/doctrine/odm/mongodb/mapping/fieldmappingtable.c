@@ -0,0 +1,746 @@
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+#include "doctrine.h"
+
+#include "ext/standard/php_smart_str.h"
+#include "ext/standard/php_var.h"
+#include "Zend/zend_interfaces.h"
+
+#include "kernel/main.h"
+#include "kernel/variables.h"
+
+/*
+ * Field mapping table
+ *--------------------
+ *
+ * A compact, read-only view of the fieldMappings of a ClassMetadata.
+ *
+ * Every mapping is kept as one fixed-size record in a contiguous array. The
+ * field name, database name and type of all the records live once in a
+ * shared string pool, next to the serialized form of each full mapping.
+ * Lookups by field name go through a perfect hash (hash and displace), so
+ * they cost two hashes of the name, one probe and one comparison. The
+ * first-level bucket comes from the hash PHP uses for the name; the slot
+ * hashes the name again, seeded with the displacement of the bucket, so
+ * names with the same PHP hash can still be told apart. If no displacement
+ * places every field, lookups fall back to a plain HashTable.
+ *
+ * The hot accessors (getType(), getDbName(), isIdentifier(), ...) answer
+ * from the records without creating any zval. The mapping arrays are only
+ * unserialized when get() or toArray() asks for them, and memoized after.
+ */
+
+static zend_object_handlers doctrine_field_mapping_table_handlers;
+
+#define DOCTRINE_FIELD_MAPPING_ID        1
+#define DOCTRINE_FIELD_MAPPING_REFERENCE 2
+#define DOCTRINE_FIELD_MAPPING_EMBEDDED  4
+#define DOCTRINE_FIELD_MAPPING_NULLABLE  8
+#define DOCTRINE_FIELD_MAPPING_INHERITED 16
+
+#define DOCTRINE_FIELD_MAPPING_EMPTY_SLOT UINT32_MAX
+#define DOCTRINE_FIELD_MAPPING_MAX_DISPLACEMENT 4096
+
+typedef struct _doctrine_field_mapping {
+	ulong hash;
+	uint32_t name;
+	uint32_t name_len;
+	uint32_t db_name;
+	uint32_t db_name_len;
+	uint32_t type;
+	uint32_t type_len;
+	uint32_t serialized;
+	uint32_t serialized_len;
+	uint32_t flags;
+} doctrine_field_mapping;
+
+typedef struct _doctrine_field_mapping_table {
+	zend_object std;
+	doctrine_field_mapping *fields;
+	uint32_t count;
+	uint32_t *slots;
+	uint32_t slot_count;
+	uint32_t *displacements;
+	uint32_t bucket_count;
+	char *pool;
+	zval **materialized;
+	HashTable *index; /**< Field name => record, when the perfect hash could not be built */
+} doctrine_field_mapping_table;
+
+/**
+ * Seeded FNV-1a of the name, independent of the hash PHP uses for it
+ */
+static zend_always_inline uint32_t doctrine_field_mapping_slot(const char *name, uint name_len, uint32_t displacement, uint32_t slot_count)
+{
+	uint32_t x = 2166136261U ^ (displacement * 0x9E3779B1U);
+	uint i;
+
+	for (i = 0; i < name_len; i++) {
+		x ^= (unsigned char) name[i];
+		x *= 16777619U;
+	}
+
+	x ^= x >> 15;
+	x *= 0x85EBCA77U;
+	x ^= x >> 13;
+
+	return x % slot_count;
+}
+
+static void doctrine_field_mapping_table_clear(doctrine_field_mapping_table *intern)
+{
+	uint32_t i;
+
+	if (intern->materialized != NULL) {
+		for (i = 0; i < intern->count; i++) {
+			if (intern->materialized[i] != NULL) {
+				zval_ptr_dtor(&intern->materialized[i]);
+			}
+		}
+		efree(intern->materialized);
+	}
+
+	if (intern->fields != NULL) {
+		efree(intern->fields);
+	}
+	if (intern->slots != NULL) {
+		efree(intern->slots);
+	}
+	if (intern->displacements != NULL) {
+		efree(intern->displacements);
+	}
+	if (intern->pool != NULL) {
+		efree(intern->pool);
+	}
+	if (intern->index != NULL) {
+		zend_hash_destroy(intern->index);
+		FREE_HASHTABLE(intern->index);
+	}
+
+	intern->fields        = NULL;
+	intern->slots         = NULL;
+	intern->displacements = NULL;
+	intern->pool          = NULL;
+	intern->materialized  = NULL;
+	intern->index         = NULL;
+	intern->count         = 0;
+	intern->slot_count    = 0;
+	intern->bucket_count  = 0;
+}
+
+static void doctrine_field_mapping_table_free(void *object TSRMLS_DC)
+{
+	doctrine_field_mapping_table *intern = (doctrine_field_mapping_table *) object;
+
+	doctrine_field_mapping_table_clear(intern);
+	zend_object_std_dtor(&intern->std TSRMLS_CC);
+	efree(intern);
+}
+
+static zend_object_value doctrine_field_mapping_table_create(zend_class_entry *ce TSRMLS_DC)
+{
+	zend_object_value retval;
+	doctrine_field_mapping_table *intern;
+
+	intern = (doctrine_field_mapping_table *) ecalloc(1, sizeof(doctrine_field_mapping_table));
+	zend_object_std_init(&intern->std, ce TSRMLS_CC);
+#if PHP_VERSION_ID >= 50400
+	object_properties_init(&intern->std, ce);
+#else
+	{
+		zval *tmp;
+		zend_hash_copy(intern->std.properties, &ce->default_properties, (copy_ctor_func_t) zval_add_ref, (void *) &tmp, sizeof(zval *));
+	}
+#endif
+
+	retval.handle = zend_objects_store_put(intern, (zend_objects_store_dtor_t) zend_objects_destroy_object, doctrine_field_mapping_table_free, NULL TSRMLS_CC);
+	retval.handlers = &doctrine_field_mapping_table_handlers;
+
+	return retval;
+}
+
+/**
+ * Appends a string to the pool and returns its offset
+ */
+static uint32_t doctrine_field_mapping_pool_add(smart_str *pool, const char *str, uint len)
+{
+	uint32_t offset = (uint32_t) pool->len;
+
+	smart_str_appendl(pool, str, len);
+	smart_str_appendc(pool, '\0');
+
+	return offset;
+}
+
+static uint32_t doctrine_field_mapping_pool_add_key(smart_str *pool, HashTable *mapping, const char *key, uint key_size, uint32_t *len)
+{
+	zval **value;
+
+	if (zend_hash_find(mapping, key, key_size, (void **) &value) == SUCCESS && Z_TYPE_PP(value) == IS_STRING) {
+		*len = Z_STRLEN_PP(value);
+		return doctrine_field_mapping_pool_add(pool, Z_STRVAL_PP(value), Z_STRLEN_PP(value));
+	}
+
+	*len = 0;
+	return doctrine_field_mapping_pool_add(pool, "", 0);
+}
+
+static int doctrine_field_mapping_flag(HashTable *mapping, const char *key, uint key_size)
+{
+	zval **value;
+
+	return zend_hash_find(mapping, key, key_size, (void **) &value) == SUCCESS && zend_is_true(*value);
+}
+
+/**
+ * Finds a displacement for every first-level bucket so that all the fields
+ * end up in distinct slots, largest buckets first
+ */
+static int doctrine_field_mapping_table_hash(doctrine_field_mapping_table *intern)
+{
+	uint32_t i, j, b, d, size, max_size, attempt, slot, *sizes, *starts, *members, *taken;
+	int placed;
+
+	if (intern->count == 0) {
+		return SUCCESS;
+	}
+
+	intern->bucket_count = intern->count / 2 + 1;
+	intern->displacements = (uint32_t *) ecalloc(intern->bucket_count, sizeof(uint32_t));
+
+	/* Group the fields by first-level bucket */
+	sizes   = (uint32_t *) ecalloc(intern->bucket_count, sizeof(uint32_t));
+	starts  = (uint32_t *) ecalloc(intern->bucket_count + 1, sizeof(uint32_t));
+	members = (uint32_t *) ecalloc(intern->count, sizeof(uint32_t));
+	taken   = (uint32_t *) ecalloc(intern->count, sizeof(uint32_t));
+
+	max_size = 0;
+	for (i = 0; i < intern->count; i++) {
+		b = intern->fields[i].hash % intern->bucket_count;
+		if (++sizes[b] > max_size) {
+			max_size = sizes[b];
+		}
+	}
+	for (b = 0; b < intern->bucket_count; b++) {
+		starts[b + 1] = starts[b] + sizes[b];
+	}
+	memset(sizes, 0, intern->bucket_count * sizeof(uint32_t));
+	for (i = 0; i < intern->count; i++) {
+		b = intern->fields[i].hash % intern->bucket_count;
+		members[starts[b] + sizes[b]++] = i;
+	}
+
+	/* Start with one slot per field and only widen the table if needed */
+	for (attempt = 0; attempt < 4; attempt++) {
+
+		intern->slot_count = intern->count << attempt;
+		if (intern->slots != NULL) {
+			efree(intern->slots);
+		}
+		intern->slots = (uint32_t *) emalloc(intern->slot_count * sizeof(uint32_t));
+		memset(intern->slots, 0xFF, intern->slot_count * sizeof(uint32_t));
+
+		placed = 1;
+		for (size = max_size; size > 0 && placed; size--) {
+			for (b = 0; b < intern->bucket_count && placed; b++) {
+
+				if (sizes[b] != size) {
+					continue;
+				}
+
+				placed = 0;
+				for (d = 0; d < DOCTRINE_FIELD_MAPPING_MAX_DISPLACEMENT; d++) {
+					for (j = 0; j < size; j++) {
+						i = members[starts[b] + j];
+						slot = doctrine_field_mapping_slot(intern->pool + intern->fields[i].name, intern->fields[i].name_len, d, intern->slot_count);
+						if (intern->slots[slot] != DOCTRINE_FIELD_MAPPING_EMPTY_SLOT) {
+							break;
+						}
+						/* Claim the slot, released below if another member collides */
+						intern->slots[slot] = i;
+						taken[j] = slot;
+					}
+
+					if (j == size) {
+						intern->displacements[b] = d;
+						placed = 1;
+						break;
+					}
+
+					while (j-- > 0) {
+						intern->slots[taken[j]] = DOCTRINE_FIELD_MAPPING_EMPTY_SLOT;
+					}
+				}
+			}
+		}
+
+		if (placed) {
+			break;
+		}
+	}
+
+	efree(sizes);
+	efree(starts);
+	efree(members);
+	efree(taken);
+
+	if (!placed) {
+		efree(intern->slots);
+		intern->slots = NULL;
+		intern->slot_count = 0;
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/**
+ * Indexes the fields in a HashTable, used when the perfect hash fails
+ */
+static void doctrine_field_mapping_table_index(doctrine_field_mapping_table *intern)
+{
+	uint32_t i;
+	const doctrine_field_mapping *field;
+
+	ALLOC_HASHTABLE(intern->index);
+	zend_hash_init(intern->index, intern->count, NULL, NULL, 0);
+
+	for (i = 0; i < intern->count; i++) {
+		field = &intern->fields[i];
+		zend_hash_quick_update(intern->index, intern->pool + field->name, field->name_len, field->hash, &i, sizeof(uint32_t), NULL);
+	}
+}
+
+static int doctrine_field_mapping_table_build(doctrine_field_mapping_table *intern, HashTable *mappings TSRMLS_DC)
+{
+	zval **value, serialized;
+	char *key;
+	uint key_len, i;
+	ulong num_key;
+	HashPosition pos;
+	smart_str pool = { 0 };
+	doctrine_field_mapping *field;
+	HashTable *mapping;
+
+	intern->count = zend_hash_num_elements(mappings);
+	intern->fields = (doctrine_field_mapping *) ecalloc(intern->count + 1, sizeof(doctrine_field_mapping));
+	intern->materialized = (zval **) ecalloc(intern->count + 1, sizeof(zval *));
+
+	i = 0;
+	zend_hash_internal_pointer_reset_ex(mappings, &pos);
+	while (zend_hash_get_current_data_ex(mappings, (void **) &value, &pos) == SUCCESS) {
+
+		if (zend_hash_get_current_key_ex(mappings, &key, &key_len, &num_key, 0, &pos) != HASH_KEY_IS_STRING || Z_TYPE_PP(value) != IS_ARRAY) {
+			zend_throw_exception_ex(spl_ce_InvalidArgumentException, 0 TSRMLS_CC, "Field mappings must be arrays indexed by field name");
+			smart_str_free(&pool);
+			doctrine_field_mapping_table_clear(intern);
+			return FAILURE;
+		}
+
+		mapping = Z_ARRVAL_PP(value);
+		field = &intern->fields[i];
+
+		field->hash     = zend_inline_hash_func(key, key_len - 1);
+		field->name     = doctrine_field_mapping_pool_add(&pool, key, key_len - 1);
+		field->name_len = key_len - 1;
+		field->db_name  = doctrine_field_mapping_pool_add_key(&pool, mapping, SS("name"), &field->db_name_len);
+		field->type     = doctrine_field_mapping_pool_add_key(&pool, mapping, SS("type"), &field->type_len);
+
+		if (doctrine_field_mapping_flag(mapping, SS("id"))) {
+			field->flags |= DOCTRINE_FIELD_MAPPING_ID;
+		}
+		if (doctrine_field_mapping_flag(mapping, SS("reference"))) {
+			field->flags |= DOCTRINE_FIELD_MAPPING_REFERENCE;
+		}
+		if (doctrine_field_mapping_flag(mapping, SS("embedded"))) {
+			field->flags |= DOCTRINE_FIELD_MAPPING_EMBEDDED;
+		}
+		if (doctrine_field_mapping_flag(mapping, SS("nullable"))) {
+			field->flags |= DOCTRINE_FIELD_MAPPING_NULLABLE;
+		}
+		if (zend_hash_exists(mapping, SS("inherited"))) {
+			field->flags |= DOCTRINE_FIELD_MAPPING_INHERITED;
+		}
+
+		INIT_ZVAL(serialized);
+		zephir_serialize(&serialized, value TSRMLS_CC);
+		if (Z_TYPE(serialized) != IS_STRING) {
+			zval_dtor(&serialized);
+			if (!EG(exception)) {
+				zend_throw_exception_ex(spl_ce_InvalidArgumentException, 0 TSRMLS_CC, "Unable to serialize the mapping of field %s", key);
+			}
+			smart_str_free(&pool);
+			doctrine_field_mapping_table_clear(intern);
+			return FAILURE;
+		}
+		field->serialized     = doctrine_field_mapping_pool_add(&pool, Z_STRVAL(serialized), Z_STRLEN(serialized));
+		field->serialized_len = Z_STRLEN(serialized);
+		zval_dtor(&serialized);
+
+		i++;
+		zend_hash_move_forward_ex(mappings, &pos);
+	}
+
+	smart_str_0(&pool);
+	intern->pool = pool.c;
+
+	if (doctrine_field_mapping_table_hash(intern) == FAILURE) {
+		doctrine_field_mapping_table_index(intern);
+	}
+
+	return SUCCESS;
+}
+
+static const doctrine_field_mapping *doctrine_field_mapping_table_find(const doctrine_field_mapping_table *intern, const char *name, uint name_len, uint32_t *index)
+{
+	ulong h;
+	uint32_t i, *found;
+	const doctrine_field_mapping *field;
+
+	h = zend_inline_hash_func(name, name_len);
+
+	if (intern->index != NULL) {
+		if (zend_hash_quick_find(intern->index, name, name_len, h, (void **) &found) == FAILURE) {
+			return NULL;
+		}
+		i = *found;
+	} else {
+		if (intern->slot_count == 0) {
+			return NULL;
+		}
+
+		i = intern->slots[doctrine_field_mapping_slot(name, name_len, intern->displacements[h % intern->bucket_count], intern->slot_count)];
+		if (i == DOCTRINE_FIELD_MAPPING_EMPTY_SLOT) {
+			return NULL;
+		}
+	}
+
+	field = &intern->fields[i];
+	if (field->hash != h || field->name_len != name_len || memcmp(intern->pool + field->name, name, name_len) != 0) {
+		return NULL;
+	}
+
+	if (index != NULL) {
+		*index = i;
+	}
+
+	return field;
+}
+
+/**
+ * Returns the mapping array of a field, unserializing it on first use
+ */
+static zval *doctrine_field_mapping_table_materialize(doctrine_field_mapping_table *intern, uint32_t index TSRMLS_DC)
+{
+	zval *mapping;
+	const unsigned char *p;
+	php_unserialize_data_t var_hash;
+	const doctrine_field_mapping *field = &intern->fields[index];
+
+	if (intern->materialized[index] != NULL) {
+		return intern->materialized[index];
+	}
+
+	MAKE_STD_ZVAL(mapping);
+	p = (const unsigned char *) intern->pool + field->serialized;
+	PHP_VAR_UNSERIALIZE_INIT(var_hash);
+	if (!php_var_unserialize(&mapping, &p, p + field->serialized_len, &var_hash TSRMLS_CC)) {
+		PHP_VAR_UNSERIALIZE_DESTROY(var_hash);
+		zval_ptr_dtor(&mapping);
+		return NULL;
+	}
+	PHP_VAR_UNSERIALIZE_DESTROY(var_hash);
+
+	intern->materialized[index] = mapping;
+	return mapping;
+}
+
+static void doctrine_field_mapping_table_to_array(doctrine_field_mapping_table *intern, zval *result TSRMLS_DC)
+{
+	uint32_t i;
+	zval *mapping;
+
+	array_init_size(result, intern->count);
+	for (i = 0; i < intern->count; i++) {
+		mapping = doctrine_field_mapping_table_materialize(intern, i TSRMLS_CC);
+		if (mapping == NULL) {
+			continue;
+		}
+		Z_ADDREF_P(mapping);
+		add_assoc_zval_ex(result, intern->pool + intern->fields[i].name, intern->fields[i].name_len + 1, mapping);
+	}
+}
+
+#define DOCTRINE_FIELD_MAPPING_TABLE_FETCH() \
+	(doctrine_field_mapping_table *) zend_object_store_get_object(getThis() TSRMLS_CC)
+
+#define DOCTRINE_FIELD_MAPPING_TABLE_FIND(field) \
+	{ \
+		char *name; \
+		int name_len; \
+		if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "s", &name, &name_len) == FAILURE) { \
+			return; \
+		} \
+		field = doctrine_field_mapping_table_find(intern, name, name_len, &index); \
+	}
+
+static int doctrine_field_mapping_table_count(zval *object, long *count TSRMLS_DC)
+{
+	doctrine_field_mapping_table *intern = (doctrine_field_mapping_table *) zend_object_store_get_object(object TSRMLS_CC);
+
+	*count = intern->count;
+	return SUCCESS;
+}
+
+/**
+ * Doctrine\ODM\MongoDB\Mapping\FieldMappingTable initializer
+ */
+ZEPHIR_INIT_CLASS(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable) {
+
+	ZEPHIR_REGISTER_CLASS(Doctrine\\ODM\\MongoDB\\Mapping, FieldMappingTable, doctrine, odm_mongodb_mapping_fieldmappingtable, doctrine_odm_mongodb_mapping_fieldmappingtable_method_entry, ZEND_ACC_FINAL_CLASS);
+
+	doctrine_odm_mongodb_mapping_fieldmappingtable_ce->create_object = doctrine_field_mapping_table_create;
+
+	memcpy(&doctrine_field_mapping_table_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+	doctrine_field_mapping_table_handlers.clone_obj = NULL;
+	doctrine_field_mapping_table_handlers.count_elements = doctrine_field_mapping_table_count;
+
+	zend_class_implements(doctrine_odm_mongodb_mapping_fieldmappingtable_ce TSRMLS_CC, 2, spl_ce_Countable, zend_ce_serializable);
+
+	return SUCCESS;
+
+}
+
+/**
+ * Builds the table from the fieldMappings of a ClassMetadata
+ *
+ * @param array fieldMappings
+ */
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, __construct) {
+
+	zval *mappings;
+	doctrine_field_mapping_table *intern = DOCTRINE_FIELD_MAPPING_TABLE_FETCH();
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "a", &mappings) == FAILURE) {
+		return;
+	}
+
+	doctrine_field_mapping_table_clear(intern);
+	doctrine_field_mapping_table_build(intern, Z_ARRVAL_P(mappings) TSRMLS_CC);
+}
+
+/**
+ * Checks whether a field is mapped
+ *
+ * @param string fieldName
+ * @return boolean
+ */
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, has) {
+
+	uint32_t index;
+	const doctrine_field_mapping *field;
+	doctrine_field_mapping_table *intern = DOCTRINE_FIELD_MAPPING_TABLE_FETCH();
+
+	DOCTRINE_FIELD_MAPPING_TABLE_FIND(field);
+	RETURN_BOOL(field != NULL);
+}
+
+/**
+ * Returns the mapping array of a field, or null if it is not mapped
+ *
+ * @param string fieldName
+ * @return array|null
+ */
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, get) {
+
+	uint32_t index;
+	zval *mapping;
+	const doctrine_field_mapping *field;
+	doctrine_field_mapping_table *intern = DOCTRINE_FIELD_MAPPING_TABLE_FETCH();
+
+	DOCTRINE_FIELD_MAPPING_TABLE_FIND(field);
+	if (field == NULL) {
+		RETURN_NULL();
+	}
+
+	mapping = doctrine_field_mapping_table_materialize(intern, index TSRMLS_CC);
+	if (mapping == NULL) {
+		RETURN_NULL();
+	}
+
+	RETURN_ZVAL(mapping, 1, 0);
+}
+
+/**
+ * Returns the mapping type of a field, or null if it is not mapped
+ *
+ * @param string fieldName
+ * @return string|null
+ */
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, getType) {
+
+	uint32_t index;
+	const doctrine_field_mapping *field;
+	doctrine_field_mapping_table *intern = DOCTRINE_FIELD_MAPPING_TABLE_FETCH();
+
+	DOCTRINE_FIELD_MAPPING_TABLE_FIND(field);
+	if (field == NULL) {
+		RETURN_NULL();
+	}
+
+	RETURN_STRINGL(intern->pool + field->type, field->type_len, 1);
+}
+
+/**
+ * Returns the database name of a field, or null if it is not mapped
+ *
+ * @param string fieldName
+ * @return string|null
+ */
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, getDbName) {
+
+	uint32_t index;
+	const doctrine_field_mapping *field;
+	doctrine_field_mapping_table *intern = DOCTRINE_FIELD_MAPPING_TABLE_FETCH();
+
+	DOCTRINE_FIELD_MAPPING_TABLE_FIND(field);
+	if (field == NULL) {
+		RETURN_NULL();
+	}
+
+	RETURN_STRINGL(intern->pool + field->db_name, field->db_name_len, 1);
+}
+
+/**
+ * Checks whether a field is the identifier
+ *
+ * @param string fieldName
+ * @return boolean
+ */
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, isIdentifier) {
+
+	uint32_t index;
+	const doctrine_field_mapping *field;
+	doctrine_field_mapping_table *intern = DOCTRINE_FIELD_MAPPING_TABLE_FETCH();
+
+	DOCTRINE_FIELD_MAPPING_TABLE_FIND(field);
+	RETURN_BOOL(field != NULL && (field->flags & DOCTRINE_FIELD_MAPPING_ID));
+}
+
+/**
+ * Checks whether a field is a reference
+ *
+ * @param string fieldName
+ * @return boolean
+ */
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, isReference) {
+
+	uint32_t index;
+	const doctrine_field_mapping *field;
+	doctrine_field_mapping_table *intern = DOCTRINE_FIELD_MAPPING_TABLE_FETCH();
+
+	DOCTRINE_FIELD_MAPPING_TABLE_FIND(field);
+	RETURN_BOOL(field != NULL && (field->flags & DOCTRINE_FIELD_MAPPING_REFERENCE));
+}
+
+/**
+ * Checks whether a field is an embedded document
+ *
+ * @param string fieldName
+ * @return boolean
+ */
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, isEmbedded) {
+
+	uint32_t index;
+	const doctrine_field_mapping *field;
+	doctrine_field_mapping_table *intern = DOCTRINE_FIELD_MAPPING_TABLE_FETCH();
+
+	DOCTRINE_FIELD_MAPPING_TABLE_FIND(field);
+	RETURN_BOOL(field != NULL && (field->flags & DOCTRINE_FIELD_MAPPING_EMBEDDED));
+}
+
+/**
+ * Returns the mapped field names, in mapping order
+ *
+ * @return array
+ */
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, getFieldNames) {
+
+	uint32_t i;
+	doctrine_field_mapping_table *intern = DOCTRINE_FIELD_MAPPING_TABLE_FETCH();
+
+	array_init_size(return_value, intern->count);
+	for (i = 0; i < intern->count; i++) {
+		add_next_index_stringl(return_value, intern->pool + intern->fields[i].name, intern->fields[i].name_len, 1);
+	}
+}
+
+/**
+ * Returns all the mapping arrays indexed by field name, as in
+ * ClassMetadata::$fieldMappings
+ *
+ * @return array
+ */
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, toArray) {
+
+	doctrine_field_mapping_table *intern = DOCTRINE_FIELD_MAPPING_TABLE_FETCH();
+
+	doctrine_field_mapping_table_to_array(intern, return_value TSRMLS_CC);
+}
+
+/**
+ * Returns the number of mapped fields
+ *
+ * @return int
+ */
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, count) {
+
+	doctrine_field_mapping_table *intern = DOCTRINE_FIELD_MAPPING_TABLE_FETCH();
+
+	RETURN_LONG(intern->count);
+}
+
+/**
+ * Serializable: tables are stored as the plain fieldMappings array
+ *
+ * @return string
+ */
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, serialize) {
+
+	zval *mappings;
+	doctrine_field_mapping_table *intern = DOCTRINE_FIELD_MAPPING_TABLE_FETCH();
+
+	MAKE_STD_ZVAL(mappings);
+	doctrine_field_mapping_table_to_array(intern, mappings TSRMLS_CC);
+
+	zephir_serialize(return_value, &mappings TSRMLS_CC);
+	zval_ptr_dtor(&mappings);
+}
+
+/**
+ * Serializable: rebuilds the table from the plain fieldMappings array
+ *
+ * @param string serialized
+ */
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, unserialize) {
+
+	zval *serialized, mappings;
+	doctrine_field_mapping_table *intern = DOCTRINE_FIELD_MAPPING_TABLE_FETCH();
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "z", &serialized) == FAILURE) {
+		return;
+	}
+
+	INIT_ZVAL(mappings);
+	zephir_unserialize(&mappings, serialized TSRMLS_CC);
+	if (Z_TYPE(mappings) == IS_ARRAY) {
+		doctrine_field_mapping_table_clear(intern);
+		doctrine_field_mapping_table_build(intern, Z_ARRVAL(mappings) TSRMLS_CC);
+	}
+	zval_dtor(&mappings);
+}
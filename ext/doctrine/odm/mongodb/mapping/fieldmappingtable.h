@@ -0,0 +1,47 @@
+
+extern zend_class_entry *doctrine_odm_mongodb_mapping_fieldmappingtable_ce;
+
+ZEPHIR_INIT_CLASS(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable);
+
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, __construct);
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, has);
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, get);
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, getType);
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, getDbName);
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, isIdentifier);
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, isReference);
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, isEmbedded);
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, getFieldNames);
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, toArray);
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, count);
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, serialize);
+PHP_METHOD(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, unserialize);
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_odm_mongodb_mapping_fieldmappingtable___construct, 0, 0, 1)
+	ZEND_ARG_ARRAY_INFO(0, fieldMappings, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_odm_mongodb_mapping_fieldmappingtable_field, 0, 0, 1)
+	ZEND_ARG_INFO(0, fieldName)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_doctrine_odm_mongodb_mapping_fieldmappingtable_unserialize, 0, 0, 1)
+	ZEND_ARG_INFO(0, serialized)
+ZEND_END_ARG_INFO()
+
+ZEPHIR_INIT_FUNCS(doctrine_odm_mongodb_mapping_fieldmappingtable_method_entry) {
+	PHP_ME(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, __construct, arginfo_doctrine_odm_mongodb_mapping_fieldmappingtable___construct, ZEND_ACC_PUBLIC|ZEND_ACC_CTOR)
+	PHP_ME(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, has, arginfo_doctrine_odm_mongodb_mapping_fieldmappingtable_field, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, get, arginfo_doctrine_odm_mongodb_mapping_fieldmappingtable_field, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, getType, arginfo_doctrine_odm_mongodb_mapping_fieldmappingtable_field, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, getDbName, arginfo_doctrine_odm_mongodb_mapping_fieldmappingtable_field, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, isIdentifier, arginfo_doctrine_odm_mongodb_mapping_fieldmappingtable_field, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, isReference, arginfo_doctrine_odm_mongodb_mapping_fieldmappingtable_field, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, isEmbedded, arginfo_doctrine_odm_mongodb_mapping_fieldmappingtable_field, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, getFieldNames, NULL, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, toArray, NULL, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, count, NULL, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, serialize, NULL, ZEND_ACC_PUBLIC)
+	PHP_ME(Doctrine_ODM_MongoDB_Mapping_FieldMappingTable, unserialize, arginfo_doctrine_odm_mongodb_mapping_fieldmappingtable_unserialize, ZEND_ACC_PUBLIC)
+	PHP_FE_END
+};
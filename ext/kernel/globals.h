@@ -41,7 +41,8 @@ typedef struct _zephir_memory_entry {
 /** Virtual Symbol Table */
 typedef struct _zephir_symbol_table {
 	struct _zephir_memory_entry *scope;
-	HashTable *symbol_table;
+	HashTable *symbol_table; /**< The symbol table to restore */
+	HashTable *table; /**< The virtual symbol table, kept when pooled */
 	struct _zephir_symbol_table *prev;
 } zephir_symbol_table;
 
@@ -45,6 +45,95 @@
  * Not all methods must grow/restore the zephir_memory_entry.
  */
 
+/*
+ * zval free list
+ *---------------
+ *
+ * Frames own the zvals they observe, so when restoring a frame releases the
+ * last reference to one its value is destroyed and the zval itself is kept
+ * in a bounded per-request free list. zephir_memory_alloc() takes zvals from
+ * that list before calling the allocator. The list is drained at RSHUTDOWN.
+ */
+static inline void zephir_zval_free(zend_zephir_globals_def *g, zval *z TSRMLS_DC)
+{
+#if PHP_VERSION_ID >= 50300
+	GC_REMOVE_ZVAL_FROM_BUFFER(z);
+#endif
+	zval_dtor(z);
+
+	/* The destructor may have run Zephir code that filled the list */
+	if (g->zval_free_count < ZEPHIR_ZVAL_FREE_LIST_SIZE) {
+		g->zval_free_list[g->zval_free_count++] = z;
+	} else {
+		FREE_ZVAL(z);
+	}
+}
+
+static inline void zephir_zval_alloc(zend_zephir_globals_def *g, zval **var)
+{
+	if (g->zval_free_count) {
+		*var = g->zval_free_list[--g->zval_free_count];
+#if PHP_VERSION_ID >= 50300
+		GC_ZVAL_INIT(*var);
+#endif
+		INIT_ZVAL(**var);
+	} else {
+		ALLOC_INIT_ZVAL(*var);
+	}
+}
+
+/**
+ * Releases the zvals kept by the free list, called from RSHUTDOWN
+ */
+void zephir_zval_free_list_drain(TSRMLS_D)
+{
+	zend_zephir_globals_def *g = ZEPHIR_VGLOBAL;
+
+	while (g->zval_free_count) {
+		FREE_ZVAL(g->zval_free_list[--g->zval_free_count]);
+	}
+}
+
+/*
+ * Symbol table pool
+ *------------------
+ *
+ * Virtual symbol tables released by their frame are cleaned and kept in a
+ * small per-request pool for the next zephir_create_symbol_table(). This
+ * saves the zephir_symbol_table, HashTable and arBuckets allocations; the
+ * Buckets themselves are freed by zend_hash_clean(). The pool is drained at
+ * RSHUTDOWN.
+ */
+static void zephir_release_symbol_table(zend_zephir_globals_def *g, zephir_symbol_table *entry TSRMLS_DC)
+{
+	/* Cleaning runs destructors, which may release tables of their own */
+	zend_hash_clean(entry->table);
+
+	if (g->symbol_table_pool_count < ZEPHIR_SYMBOL_TABLE_POOL_SIZE) {
+		g->symbol_table_pool[g->symbol_table_pool_count++] = entry;
+	} else {
+		zend_hash_destroy(entry->table);
+		FREE_HASHTABLE(entry->table);
+		efree(entry);
+	}
+}
+
+/**
+ * Releases the pooled symbol tables, called from RSHUTDOWN
+ */
+void zephir_symbol_table_pool_drain(TSRMLS_D)
+{
+	zend_zephir_globals_def *g = ZEPHIR_VGLOBAL;
+	zephir_symbol_table *entry;
+
+	while (g->symbol_table_pool_count) {
+		entry = g->symbol_table_pool[--g->symbol_table_pool_count];
+		zend_hash_destroy(entry->table);
+		FREE_HASHTABLE(entry->table);
+		efree(entry);
+	}
+}
+
 static zephir_memory_entry* zephir_memory_grow_stack_common(zend_zephir_globals_def *g)
 {
 	assert(g->start_memory != NULL);
@@ -57,6 +146,7 @@ static zephir_memory_entry* zephir_memory_grow_stack_common(zend_zephir_globals_
 	else if (!g->active_memory->next) {
 		assert(g->active_memory >= g->end_memory - 1 || g->active_memory < g->start_memory);
 		zephir_memory_entry *entry = (zephir_memory_entry *) ecalloc(1, sizeof(zephir_memory_entry));
+		++g->memory_overflow_frames;
 	/* ecalloc() will take care of these members
 		entry->pointer   = 0;
 		entry->capacity  = 0;
@@ -85,6 +175,10 @@ static zephir_memory_entry* zephir_memory_grow_stack_common(zend_zephir_globals_
 	assert(g->active_memory->pointer == 0);
 	assert(g->active_memory->hash_pointer == 0);
 
+	if (++g->memory_depth > g->memory_depth_peak) {
+		g->memory_depth_peak = g->memory_depth;
+	}
+
 	return g->active_memory;
 }
 
@@ -102,11 +196,9 @@ static void zephir_memory_restore_stack_common(zend_zephir_globals_def *g TSRMLS
 		if (g->active_symbol_table) {
 			active_symbol_table = g->active_symbol_table;
 			if (active_symbol_table->scope == active_memory) {
-				zend_hash_destroy(EG(active_symbol_table));
-				FREE_HASHTABLE(EG(active_symbol_table));
 				EG(active_symbol_table) = active_symbol_table->symbol_table;
 				g->active_symbol_table = active_symbol_table->prev;
-				efree(active_symbol_table);
+				zephir_release_symbol_table(g, active_symbol_table TSRMLS_CC);
 			}
 		}
 
@@ -154,7 +246,7 @@ static void zephir_memory_restore_stack_common(zend_zephir_globals_def *g TSRMLS
 		for (i = 0; i < active_memory->pointer; ++i) {
 			if (EXPECTED(active_memory->addresses[i] != NULL && *(active_memory->addresses[i]) != NULL)) {
 				if (Z_REFCOUNT_PP(active_memory->addresses[i]) == 1) {
-					zval_ptr_dtor(active_memory->addresses[i]);
+					zephir_zval_free(g, *active_memory->addresses[i] TSRMLS_CC);
 				} else {
 					Z_DELREF_PP(active_memory->addresses[i]);
 				}
@@ -166,6 +258,7 @@ static void zephir_memory_restore_stack_common(zend_zephir_globals_def *g TSRMLS
 	active_memory->func = NULL;
 #endif
 
+	--g->memory_depth;
 	prev = active_memory->prev;
 
 	if (active_memory >= g->end_memory || active_memory < g->start_memory) {
@@ -327,7 +420,7 @@ int ZEND_FASTCALL zephir_memory_restore_stack(TSRMLS_D)
 }
 #endif
 
-ZEPHIR_ATTR_NONNULL static void zephir_reallocate_memory(const zend_zephir_globals_def *g)
+ZEPHIR_ATTR_NONNULL static void zephir_reallocate_memory(zend_zephir_globals_def *g)
 {
 	zephir_memory_entry *frame = g->active_memory;
 	int persistent = (frame >= g->start_memory && frame < g->end_memory);
@@ -335,6 +428,13 @@ ZEPHIR_ATTR_NONNULL static void zephir_reallocate_memory(const zend_zephir_globa
 	if (EXPECTED(buf != NULL)) {
 		frame->capacity += 16;
 		frame->addresses = buf;
+		++g->memory_reallocations;
+		if (frame->capacity > g->memory_capacity_peak) {
+			g->memory_capacity_peak = frame->capacity;
+		}
+		if (g->memory_depth <= ZEPHIR_MAX_PREALLOCATED_FRAMES && frame->capacity > g->memory_capacity_peaks[g->memory_depth - 1]) {
+			g->memory_capacity_peaks[g->memory_depth - 1] = frame->capacity;
+		}
 	}
 	else {
 		zend_error(E_CORE_ERROR, "Memory allocation failed");
@@ -345,7 +445,7 @@ ZEPHIR_ATTR_NONNULL static void zephir_reallocate_memory(const zend_zephir_globa
 #endif
 }
 
-ZEPHIR_ATTR_NONNULL static void zephir_reallocate_hmemory(const zend_zephir_globals_def *g)
+ZEPHIR_ATTR_NONNULL static void zephir_reallocate_hmemory(zend_zephir_globals_def *g)
 {
 	zephir_memory_entry *frame = g->active_memory;
 	int persistent = (frame >= g->start_memory && frame < g->end_memory);
@@ -353,6 +453,13 @@ ZEPHIR_ATTR_NONNULL static void zephir_reallocate_hmemory(const zend_zephir_glob
 	if (EXPECTED(buf != NULL)) {
 		frame->hash_capacity += 4;
 		frame->hash_addresses = buf;
+		++g->memory_reallocations;
+		if (frame->hash_capacity > g->memory_hash_capacity_peak) {
+			g->memory_hash_capacity_peak = frame->hash_capacity;
+		}
+		if (g->memory_depth <= ZEPHIR_MAX_PREALLOCATED_FRAMES && frame->hash_capacity > g->memory_hash_capacity_peaks[g->memory_depth - 1]) {
+			g->memory_hash_capacity_peaks[g->memory_depth - 1] = frame->hash_capacity;
+		}
 	}
 	else {
 		zend_error(E_CORE_ERROR, "Memory allocation failed");
@@ -363,7 +470,7 @@ ZEPHIR_ATTR_NONNULL static void zephir_reallocate_hmemory(const zend_zephir_glob
 #endif
 }
 
-ZEPHIR_ATTR_NONNULL1(2) static inline void zephir_do_memory_observe(zval **var, const zend_zephir_globals_def *g)
+ZEPHIR_ATTR_NONNULL1(2) static inline void zephir_do_memory_observe(zval **var, zend_zephir_globals_def *g)
 {
 	zephir_memory_entry *frame = g->active_memory;
 #ifndef ZEPHIR_RELEASE
@@ -412,7 +519,7 @@ void ZEND_FASTCALL zephir_memory_alloc(zval **var TSRMLS_DC)
 {
 	zend_zephir_globals_def *g = ZEPHIR_VGLOBAL;
 	zephir_do_memory_observe(var, g);
-	ALLOC_INIT_ZVAL(*var);
+	zephir_zval_alloc(g, var);
 }
 
 /**
@@ -433,7 +540,7 @@ void ZEND_FASTCALL zephir_memory_alloc_pnull(zval **var TSRMLS_DC)
 #endif
 
 	zephir_do_memory_observe(var, g);
-	ALLOC_INIT_ZVAL(*var);
+	zephir_zval_alloc(g, var);
 
 	if (active_memory->hash_pointer == active_memory->hash_capacity) {
 		zephir_reallocate_hmemory(g);
@@ -493,14 +600,21 @@ void zephir_create_symbol_table(TSRMLS_D) {
 	}
 #endif
 
-	entry = (zephir_symbol_table *) emalloc(sizeof(zephir_symbol_table));
+	if (zephir_globals_ptr->symbol_table_pool_count) {
+		entry = zephir_globals_ptr->symbol_table_pool[--zephir_globals_ptr->symbol_table_pool_count];
+		symbol_table = entry->table;
+	} else {
+		entry = (zephir_symbol_table *) emalloc(sizeof(zephir_symbol_table));
+		ALLOC_HASHTABLE(symbol_table);
+		zend_hash_init(symbol_table, 0, NULL, ZVAL_PTR_DTOR, 0);
+		entry->table = symbol_table;
+	}
+
 	entry->scope = zephir_globals_ptr->active_memory;
 	entry->symbol_table = EG(active_symbol_table);
 	entry->prev = zephir_globals_ptr->active_symbol_table;
 	zephir_globals_ptr->active_symbol_table = entry;
 
-	ALLOC_HASHTABLE(symbol_table);
-	zend_hash_init(symbol_table, 0, NULL, ZVAL_PTR_DTOR, 0);
 	EG(active_symbol_table) = symbol_table;
 }
 
@@ -51,11 +51,13 @@ void ZEPHIR_FASTCALL zephir_memory_alloc(zval **var TSRMLS_DC);
 void ZEPHIR_FASTCALL zephir_memory_alloc_pnull(zval **var TSRMLS_DC);
 
 int ZEPHIR_FASTCALL zephir_clean_restore_stack(TSRMLS_D);
+void zephir_zval_free_list_drain(TSRMLS_D);
 
 /* Virtual symbol tables */
 void zephir_create_symbol_table(TSRMLS_D);
 /*void zephir_restore_symbol_table(TSRMLS_D);*/
 void zephir_clean_symbol_tables(TSRMLS_D);
+void zephir_symbol_table_pool_drain(TSRMLS_D);
 
 /** Export symbols to active symbol table */
 int zephir_set_symbol(zval *key_name, zval *value TSRMLS_DC);
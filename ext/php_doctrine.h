@@ -1,5 +1,9 @@
 
-/* This file was generated automatically by Zephir do not modify it! */
+/*
+ * Generated by Zephir, maintained by hand since: it also wires in the native
+ * modules, which Zephir has no hook for. See ext/README.md before
+ * regenerating it.
+ */
 
 #ifndef PHP_DOCTRINE_H
 #define PHP_DOCTRINE_H 1
@@ -15,6 +19,12 @@
 #define PHP_DOCTRINE_ZEPVERSION  "0.4.6a"
 #define PHP_DOCTRINE_DESCRIPTION ""
 
+#define DOCTRINE_METADATA_STAT_COUNT 10
+
+#define ZEPHIR_MAX_PREALLOCATED_FRAMES 256
+#define ZEPHIR_ZVAL_FREE_LIST_SIZE 512
+#define ZEPHIR_SYMBOL_TABLE_POOL_SIZE 16
+
 
 
 ZEND_BEGIN_MODULE_GLOBALS(doctrine)
@@ -24,8 +34,24 @@ ZEND_BEGIN_MODULE_GLOBALS(doctrine)
 	zephir_memory_entry *end_memory; /**< The last preallocate frame */
 	zephir_memory_entry *active_memory; /**< The current memory frame */
 
+	/* Memory high-water marks, kept across requests to size the pool */
+	size_t memory_depth; /**< Number of active frames */
+	size_t memory_depth_peak; /**< Deepest frame stack seen */
+	size_t memory_capacity_peak; /**< Largest addresses array of a frame */
+	size_t memory_hash_capacity_peak; /**< Largest hash_addresses array of a frame */
+	size_t memory_capacity_peaks[ZEPHIR_MAX_PREALLOCATED_FRAMES]; /**< Largest addresses array per depth */
+	size_t memory_hash_capacity_peaks[ZEPHIR_MAX_PREALLOCATED_FRAMES]; /**< Largest hash_addresses array per depth */
+	unsigned long memory_overflow_frames; /**< Frames allocated past the pool */
+	unsigned long memory_reallocations; /**< Times a frame had to grow */
+
+	/* zvals released by memory frames, reused by the next allocations */
+	zval *zval_free_list[ZEPHIR_ZVAL_FREE_LIST_SIZE];
+	size_t zval_free_count;
+
 	/* Virtual Symbol Tables */
 	zephir_symbol_table *active_symbol_table;
+	zephir_symbol_table *symbol_table_pool[ZEPHIR_SYMBOL_TABLE_POOL_SIZE]; /**< Cleaned tables of the request */
+	size_t symbol_table_pool_count;
 
 	/** Function cache */
 	HashTable *fcache;
@@ -37,6 +63,21 @@ ZEND_BEGIN_MODULE_GLOBALS(doctrine)
 	zval *global_true;
 	zval *global_false;
 	zval *global_null;
+
+	/* Real class names of proxies, kept across requests */
+	HashTable *real_class_cache;
+	zend_bool real_class_cache_enabled;
+	unsigned long real_class_hits;
+	unsigned long real_class_misses;
+
+	/* Property handles of the request */
+	HashTable *property_handles;
+
+#ifdef DOCTRINE_METADATA_STATS
+	/* Metadata factory counters and cumulative nanoseconds */
+	unsigned long metadata_stats_count[DOCTRINE_METADATA_STAT_COUNT];
+	unsigned long metadata_stats_time[DOCTRINE_METADATA_STAT_COUNT];
+#endif
 	
 ZEND_END_MODULE_GLOBALS(doctrine)
 
@@ -0,0 +1,48 @@
+--TEST--
+FieldMappingTable - a failed build leaves an empty table
+--SKIPIF--
+<?php if (!extension_loaded('doctrine')) print 'skip'; ?>
+--FILE--
+<?php
+use Doctrine\ODM\MongoDB\Mapping\FieldMappingTable;
+
+$table = new FieldMappingTable(array(
+    'id' => array('fieldName' => 'id', 'name' => '_id', 'type' => 'id', 'id' => true),
+));
+
+// The second mapping is not an array
+try {
+    $table->__construct(array(
+        'name' => array('fieldName' => 'name', 'name' => 'name', 'type' => 'string'),
+        'broken' => 'string',
+    ));
+} catch (InvalidArgumentException $e) {
+    echo get_class($e), ': ', $e->getMessage(), "\n";
+}
+var_dump(count($table), $table->getFieldNames(), $table->toArray(), $table->get('name'), $table->has('id'));
+
+// The second mapping cannot be serialized
+try {
+    $table->__construct(array(
+        'name' => array('fieldName' => 'name', 'name' => 'name', 'type' => 'string'),
+        'callback' => array('fieldName' => 'callback', 'name' => 'callback', 'type' => 'string', 'closure' => function () {}),
+    ));
+} catch (Exception $e) {
+    echo get_class($e), "\n";
+}
+var_dump(count($table), $table->getFieldNames(), $table->get('name'));
+?>
+--EXPECT--
+InvalidArgumentException: Field mappings must be arrays indexed by field name
+int(0)
+array(0) {
+}
+array(0) {
+}
+NULL
+bool(false)
+Exception
+int(0)
+array(0) {
+}
+NULL
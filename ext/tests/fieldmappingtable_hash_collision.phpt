@@ -0,0 +1,38 @@
+--TEST--
+FieldMappingTable - field names with colliding hashes
+--SKIPIF--
+<?php if (!extension_loaded('doctrine')) print 'skip'; ?>
+--FILE--
+<?php
+use Doctrine\ODM\MongoDB\Mapping\FieldMappingTable;
+
+// "Ez" and "FY" have the same DJBX33A hash, as do "EzEz", "EzFY", "FYEz" and "FYFY"
+$mappings = array();
+foreach (array('Ez', 'FY', 'EzEz', 'EzFY', 'FYEz', 'FYFY') as $fieldName) {
+    $mappings[$fieldName] = array('fieldName' => $fieldName, 'name' => strtolower($fieldName), 'type' => 'string');
+}
+$mappings['id'] = array('fieldName' => 'id', 'name' => '_id', 'type' => 'id', 'id' => true);
+
+$table = new FieldMappingTable($mappings);
+var_dump(count($table));
+foreach (array_keys($mappings) as $fieldName) {
+    echo $fieldName, ' => ', $table->getDbName($fieldName), "\n";
+}
+var_dump($table->has('GZ'), $table->isIdentifier('id'), $table->isIdentifier('FY'));
+
+$copy = unserialize(serialize($table));
+var_dump($copy->getDbName('FYEz'));
+?>
+--EXPECT--
+int(7)
+Ez => ez
+FY => fy
+EzEz => ezez
+EzFY => ezfy
+FYEz => fyez
+FYFY => fyfy
+id => _id
+bool(false)
+bool(true)
+bool(false)
+string(4) "fyez"
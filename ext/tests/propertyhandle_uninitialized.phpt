@@ -0,0 +1,37 @@
+--TEST--
+PropertyHandle - handles can only be obtained from PropertyHandle::get()
+--SKIPIF--
+<?php if (!extension_loaded('doctrine')) print 'skip'; ?>
+--FILE--
+<?php
+use Doctrine\Common\Reflection\PropertyHandle;
+
+class Document
+{
+    private $id = 42;
+}
+
+$handle = PropertyHandle::get('Document', 'id');
+var_dump($handle->getClassName(), $handle->getValue(new Document()));
+
+var_dump(unserialize('O:39:"Doctrine\Common\Reflection\PropertyHandle":0:{}'));
+
+try {
+    serialize($handle);
+} catch (Exception $e) {
+    echo get_class($e), ': ', $e->getMessage(), "\n";
+}
+
+new PropertyHandle();
+?>
+--EXPECTF--
+string(8) "Document"
+int(42)
+
+Warning: Erroneous data format for unserializing 'Doctrine\Common\Reflection\PropertyHandle' in %s on line %d
+
+Notice: unserialize(): Error at offset %d of %d bytes in %s on line %d
+bool(false)
+Exception: Serialization of 'Doctrine\Common\Reflection\PropertyHandle' is not allowed
+
+Fatal error: Call to private Doctrine\Common\Reflection\PropertyHandle::__construct() from invalid context in %s on line %d
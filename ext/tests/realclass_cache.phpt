@@ -0,0 +1,40 @@
+--TEST--
+doctrine_get_real_class() - proxy names and the real class name memo
+--SKIPIF--
+<?php if (!extension_loaded('doctrine')) print 'skip'; ?>
+--INI--
+doctrine.real_class_cache=1
+--FILE--
+<?php
+$names = array(
+    'Documents\User',
+    'Proxies\__CG__\Documents\User',
+    'Proxies\__CG__\Proxies\__CG__\Documents\User',
+    '\__CG__\Documents\User',
+    '\__CG__\\',
+    '__CG__',
+    '',
+);
+
+foreach ($names as $name) {
+    var_dump(doctrine_get_real_class($name));
+}
+foreach ($names as $name) {
+    doctrine_get_real_class($name);
+}
+
+$info = doctrine_real_class_cache_info();
+var_dump($info['enabled'], $info['hits'], $info['misses'], $info['entries']);
+?>
+--EXPECT--
+string(14) "Documents\User"
+string(14) "Documents\User"
+string(14) "Documents\User"
+string(14) "Documents\User"
+string(0) ""
+string(6) "__CG__"
+string(0) ""
+bool(true)
+int(7)
+int(7)
+int(7)